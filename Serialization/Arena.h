@@ -0,0 +1,59 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include "Serialization/MemoryReader.h"
+#include "Serialization/SerializeFuncs.h"
+
+namespace TK
+{
+	// bump pointer arena for decoding one message at a time into std::pmr types. the first
+	// InlineSize bytes live in the arena itself, more is taken from the heap in growing chunks.
+	// Reset() frees everything at once, the objects loaded from it must be gone by then.
+	//
+	// a loaded type has to be allocator aware, a struct with std::pmr members declares
+	// allocator_type and a constructor taking one that hands it to every member, see FChat in the
+	// tests. members it does not pass the allocator to still allocate from the default resource.
+	//
+	//     TK::FMessageArena Arena;
+	//     auto Chat = Arena.Load<FChat>(Reader);   // FChat holds std::pmr members
+	//     Handle(Chat);
+	//     ...
+	//     Arena.Reset();
+	template<std::size_t InlineSize = 4096>
+	class TMessageArena
+	{
+	public:
+
+		using AllocatorType = std::pmr::polymorphic_allocator<std::byte>;
+
+		TMessageArena() : Resource(Inline.data(), Inline.size()) {}
+
+		TMessageArena(const TMessageArena&) = delete;
+		TMessageArena& operator=(const TMessageArena&) = delete;
+
+		std::pmr::memory_resource* GetResource() { return &Resource; }
+
+		AllocatorType GetAllocator() { return AllocatorType(&Resource); }
+
+		// a T built with the arena's allocator, then loaded from Stream.
+		template<typename T, typename StreamType>
+		T Load(StreamType& Stream)
+		{
+			static_assert(IsAllocatorAware<T, AllocatorType>, "T would not allocate from the arena, declare allocator_type and a constructor taking one");
+
+			T Data = MakeWithAllocator<T>(GetAllocator());
+			Stream & Data;
+			return Data;
+		}
+
+		void Reset() { Resource.release(); }
+
+	private:
+
+		alignas(std::max_align_t) std::array<std::byte, InlineSize> Inline;
+		std::pmr::monotonic_buffer_resource Resource;
+	};
+
+	using FMessageArena = TMessageArena<>;
+}
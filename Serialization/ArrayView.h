@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+namespace TK
+{
+	// non-owning view over a contiguous run of T. loading one from an FMemReader points it
+	// straight into the reader's buffer, so it is valid only while that buffer is alive. the
+	// elements there are packed and usually not aligned for T, so they are read by value.
+	template<typename T>
+	class TArrayView
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "views need trivially copyable elements.");
+
+	public:
+
+		class FIterator
+		{
+		public:
+
+			using iterator_category = std::input_iterator_tag;
+			using value_type = T;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = T;
+
+			explicit FIterator(const char* InPos) : Pos(InPos) {}
+
+			T operator*() const
+			{
+				T Value;
+				std::memcpy(&Value, Pos, sizeof(T));
+				return Value;
+			}
+
+			FIterator& operator++()
+			{
+				Pos += sizeof(T);
+				return *this;
+			}
+
+			FIterator operator++(int)
+			{
+				FIterator Old = *this;
+				Pos += sizeof(T);
+				return Old;
+			}
+
+			bool operator==(const FIterator& Other) const { return Pos == Other.Pos; }
+
+			bool operator!=(const FIterator& Other) const { return Pos != Other.Pos; }
+
+		private:
+
+			const char* Pos;
+		};
+
+		TArrayView() = default;
+
+		TArrayView(const T* InData, std::size_t InSize) : Data(reinterpret_cast<const char*>(InData)), Size(InSize) {}
+
+		template<typename AllocatorType>
+		TArrayView(const std::vector<T, AllocatorType>& Source) : TArrayView(Source.data(), Source.size()) {}
+
+		// Size elements of T packed at Bytes, with any alignment.
+		static TArrayView FromBytes(const void* Bytes, std::size_t Size)
+		{
+			TArrayView View;
+			View.Data = static_cast<const char*>(Bytes);
+			View.Size = Size;
+			return View;
+		}
+
+		const void* GetData() const { return Data; }
+
+		std::size_t GetSize() const { return Size; }
+
+		bool IsEmpty() const { return Size == 0; }
+
+		T operator[](std::size_t Index) const { return *FIterator(Data + Index * sizeof(T)); }
+
+		FIterator begin() const { return FIterator(Data); }
+
+		FIterator end() const { return FIterator(Data + Size * sizeof(T)); }
+
+	private:
+
+		const char* Data {nullptr};
+		std::size_t Size {0};
+	};
+}
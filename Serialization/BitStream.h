@@ -0,0 +1,289 @@
+#pragma once
+#include <cstring>
+#include <vector>
+#include "Serialization/OutStream.h"
+#include "Serialization/InStream.h"
+#include "Serialization/SerializeDefines.h"
+
+namespace TK
+{
+	constexpr int BitWidth(std::uint64_t Value)
+	{
+		int Bits = 0;
+		while (Value != 0)
+		{
+			Value >>= 1;
+			++Bits;
+		}
+		return Bits;
+	}
+
+	constexpr std::uint64_t LowBitsMask(int Bits)
+	{
+		return Bits >= 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << Bits) - 1;
+	}
+
+	// bit granular writer. bits are packed LSB first and committed to the buffer 64 at a time.
+	// bools and TK::Ranged values take only the bits they need when saved through the concrete
+	// type, everything else is written as whole bytes at the current bit position.
+	// call Flush() before reading GetBuffer()/GetSize(), it pads the last byte with zeros.
+	class FBitWriter : public TOutStream<FBitWriter>
+	{
+		friend class TOutStream<FBitWriter>;
+
+	public:
+
+		void WriteBits(std::uint64_t Value, int Bits)
+		{
+			if (Bits <= 0)
+				return;
+
+			Value &= LowBitsMask(Bits);
+			Scratch |= Value << ScratchBits;
+
+			int Total = ScratchBits + Bits;
+			if (Total >= 64)
+			{
+				Commit(Scratch, 8);
+				Scratch = ScratchBits == 0 ? 0 : Value >> (64 - ScratchBits);
+				ScratchBits = Total - 64;
+			}
+			else
+			{
+				ScratchBits = Total;
+			}
+		}
+
+		// commits pending bits, padding up to the next byte boundary.
+		void Flush()
+		{
+			if (ScratchBits > 0)
+			{
+				Commit(Scratch, (ScratchBits + 7) / 8);
+				Scratch = 0;
+				ScratchBits = 0;
+			}
+		}
+
+		std::uint64_t GetBitsWritten() const { return Buffer.size() * 8 + ScratchBits; }
+
+		std::size_t GetSize() const { return Buffer.size(); }
+
+		const char* GetBuffer() const { return Buffer.data(); }
+
+		void Reserve(std::size_t Capacity) { Buffer.reserve(Capacity); }
+
+		void Clear()
+		{
+			bValidOutput = true;
+			Buffer.clear();
+			Scratch = 0;
+			ScratchBits = 0;
+		}
+
+	protected:
+
+		bool PushBytes(const void* Source, SizeType Length)
+		{
+			if (Length <= 0)
+				return true;
+
+			auto Bytes = static_cast<const char*>(Source);
+			if (ScratchBits % 8 == 0)
+			{
+				Flush();
+				Buffer.insert(Buffer.end(), Bytes, Bytes + Length);
+				return true;
+			}
+
+			while (Length > 0)
+			{
+				int Chunk = Length < 8 ? static_cast<int>(Length) : 8;
+				std::uint64_t Value = 0;
+				std::memcpy(&Value, Bytes, Chunk);
+				WriteBits(Value, Chunk * 8);
+
+				Bytes += Chunk;
+				Length -= Chunk;
+			}
+			return true;
+		}
+
+		void Commit(std::uint64_t Value, int Bytes)
+		{
+			char Raw[8];
+			std::memcpy(Raw, &Value, sizeof(Value));
+			Buffer.insert(Buffer.end(), Raw, Raw + Bytes);
+		}
+
+		std::vector<char> Buffer;
+		std::uint64_t Scratch {0};
+		int ScratchBits {0};
+	};
+
+	// reads what FBitWriter produced, refilling a 64 bit cache from the buffer.
+	class FBitReader : public TInStream<FBitReader>
+	{
+		friend class TInStream<FBitReader>;
+
+	public:
+
+		FBitReader() = default;
+
+		template<typename InSizeType>
+		FBitReader(const void* Source, InSizeType Length) : Buffer(static_cast<const char*>(Source)), Size(static_cast<SizeType>(Length)) {}
+
+		std::uint64_t ReadBits(int Bits)
+		{
+			if (Bits <= 0 || !bValidInput)
+				return 0;
+
+			if (Bits <= CacheBits)
+				return Consume(Bits);
+
+			std::uint64_t Result = Cache;
+			int Got = CacheBits;
+
+			Refill();
+			int Need = Bits - Got;
+			if (Need > CacheBits)
+			{
+				bValidInput = false;
+				return 0;
+			}
+
+			Result |= Consume(Need) << Got;
+			return Result;
+		}
+
+		// drops the remaining bits of the current byte, the counterpart of FBitWriter::Flush.
+		void AlignToByte()
+		{
+			Consume(CacheBits % 8);
+		}
+
+		std::uint64_t GetUnreadBits() const { return static_cast<std::uint64_t>(Size - Offset) * 8 + CacheBits; }
+
+		virtual bool EnsureEnoughBytes(SizeType BytesNum) const override
+		{
+			return BytesNum >= 0 && GetUnreadBits() >= static_cast<std::uint64_t>(BytesNum) * 8;
+		}
+
+	protected:
+
+		bool PopBytes(void* Dest, SizeType Length)
+		{
+			if (Length < 0 || !EnsureEnoughBytes(Length))
+				return false;
+
+			auto Bytes = static_cast<char*>(Dest);
+			if (CacheBits % 8 == 0)
+			{
+				while (CacheBits > 0 && Length > 0)
+				{
+					*Bytes++ = static_cast<char>(Consume(8));
+					--Length;
+				}
+
+				std::memcpy(Bytes, Buffer + Offset, static_cast<std::size_t>(Length));
+				Offset += Length;
+				return true;
+			}
+
+			while (Length > 0)
+			{
+				int Chunk = Length < 8 ? static_cast<int>(Length) : 8;
+				std::uint64_t Value = ReadBits(Chunk * 8);
+				std::memcpy(Bytes, &Value, Chunk);
+
+				Bytes += Chunk;
+				Length -= Chunk;
+			}
+			return bValidInput;
+		}
+
+		std::uint64_t Consume(int Bits)
+		{
+			std::uint64_t Result = Cache & LowBitsMask(Bits);
+			Cache = Bits >= 64 ? 0 : Cache >> Bits;
+			CacheBits -= Bits;
+			return Result;
+		}
+
+		void Refill()
+		{
+			SizeType Bytes = Size - Offset < 8 ? Size - Offset : 8;
+			Cache = 0;
+			if (Bytes > 0)
+				std::memcpy(&Cache, Buffer + Offset, static_cast<std::size_t>(Bytes));
+			Offset += Bytes;
+			CacheBits = static_cast<int>(Bytes) * 8;
+		}
+
+		const char* Buffer {nullptr};
+		SizeType Size {0};
+		SizeType Offset {0};
+		std::uint64_t Cache {0};
+		int CacheBits {0};
+	};
+
+	template<typename StreamType>
+	inline constexpr bool IsBitStream = std::is_base_of_v<FBitWriter, StreamType> || std::is_base_of_v<FBitReader, StreamType>;
+
+	// TK::Ranged<Min, Max>(Field) inside TK_SERIAL. bit streams store Field - Min in just enough
+	// bits for Max - Min, byte streams store Field as usual. values outside the range are rejected
+	// on both save and load.
+	template<typename T, auto Min, auto Max>
+	struct TRangedRef
+	{
+		static_assert(std::is_integral_v<std::remove_const_t<T>> || std::is_enum_v<std::remove_const_t<T>>,
+			"Ranged only supports integers and enums.");
+		static_assert(!(Max < Min), "Max must not be less than Min.");
+
+		using ValueType = std::remove_const_t<T>;
+
+		template<typename V>
+		static constexpr std::uint64_t ToBits(V Value)
+		{
+			if constexpr (std::is_enum_v<V>)
+			{
+				return static_cast<std::uint64_t>(static_cast<std::underlying_type_t<V>>(Value));
+			}
+			else
+			{
+				return static_cast<std::uint64_t>(Value);
+			}
+		}
+
+		static constexpr std::uint64_t Span = ToBits(Max) - ToBits(Min);
+		static constexpr int Bits = BitWidth(Span);
+
+		static ValueType FromBits(std::uint64_t Raw)
+		{
+			if constexpr (std::is_enum_v<ValueType>)
+			{
+				return static_cast<ValueType>(static_cast<std::underlying_type_t<ValueType>>(Raw));
+			}
+			else
+			{
+				return static_cast<ValueType>(Raw);
+			}
+		}
+
+		static bool InRange(ValueType Value)
+		{
+			return !(Value < static_cast<ValueType>(Min)) && !(static_cast<ValueType>(Max) < Value);
+		}
+
+		T& Value;
+	};
+
+	template<auto Min, auto Max, typename T>
+	TRangedRef<T, Min, Max> Ranged(T& Value)
+	{
+		return TRangedRef<T, Min, Max>{Value};
+	}
+
+	template<typename T, auto Min, auto Max>
+	inline constexpr bool IsSerialProxy<TRangedRef<T, Min, Max>> = true;
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace TK
+{
+	struct FBufferPoolStats
+	{
+		std::uint64_t Hits {0};
+		std::uint64_t Misses {0};
+	};
+
+	// per thread cache of heap blocks in power of two size classes. requests are rounded up to
+	// their class, blocks larger than the biggest class bypass the pool. a block may be freed on
+	// another thread, it then joins that thread's cache.
+	class FBufferPool
+	{
+	public:
+
+		static constexpr int MinClassBits = 6;
+		static constexpr int MaxClassBits = 20;
+		static constexpr int ClassNum = MaxClassBits - MinClassBits + 1;
+		static constexpr std::size_t MaxCachedPerClass = 64;
+
+		static FBufferPool& Get()
+		{
+			thread_local FBufferPool Pool;
+			return Pool;
+		}
+
+		FBufferPool() = default;
+
+		FBufferPool(const FBufferPool&) = delete;
+		FBufferPool& operator=(const FBufferPool&) = delete;
+
+		~FBufferPool()
+		{
+			for (auto& Blocks : Free)
+			{
+				for (void* Block : Blocks)
+				{
+					::operator delete(Block);
+				}
+			}
+		}
+
+		// -1 when Size is above the biggest class.
+		static int GetSizeClass(std::size_t Size)
+		{
+			int Bits = MinClassBits;
+			while (Bits <= MaxClassBits && (std::size_t(1) << Bits) < Size)
+			{
+				++Bits;
+			}
+			return Bits <= MaxClassBits ? Bits - MinClassBits : -1;
+		}
+
+		void* Allocate(std::size_t Size)
+		{
+			int Class = GetSizeClass(Size);
+			if (Class < 0)
+				return ::operator new(Size);
+
+			auto& Blocks = Free[Class];
+			if (Blocks.empty())
+			{
+				++Stats.Misses;
+				return ::operator new(std::size_t(1) << (Class + MinClassBits));
+			}
+
+			++Stats.Hits;
+			void* Block = Blocks.back();
+			Blocks.pop_back();
+			return Block;
+		}
+
+		// Size must be what was passed to Allocate.
+		void Deallocate(void* Block, std::size_t Size)
+		{
+			int Class = GetSizeClass(Size);
+			if (Class < 0 || Free[Class].size() >= MaxCachedPerClass)
+			{
+				::operator delete(Block);
+				return;
+			}
+
+			Free[Class].push_back(Block);
+		}
+
+		const FBufferPoolStats& GetStats() const { return Stats; }
+
+		void ResetStats() { Stats = {}; }
+
+	private:
+
+		std::array<std::vector<void*>, ClassNum> Free;
+		FBufferPoolStats Stats;
+	};
+
+	// stateless std allocator over FBufferPool, plugs into TMemWriter<N, TPoolAllocator<char>>.
+	template<typename T>
+	class TPoolAllocator
+	{
+	public:
+
+		using value_type = T;
+
+		TPoolAllocator() = default;
+
+		template<typename U>
+		TPoolAllocator(const TPoolAllocator<U>&) {}
+
+		T* allocate(std::size_t Num)
+		{
+			return static_cast<T*>(FBufferPool::Get().Allocate(Num * sizeof(T)));
+		}
+
+		void deallocate(T* Block, std::size_t Num)
+		{
+			FBufferPool::Get().Deallocate(Block, Num * sizeof(T));
+		}
+
+		template<typename U>
+		bool operator==(const TPoolAllocator<U>&) const { return true; }
+
+		template<typename U>
+		bool operator!=(const TPoolAllocator<U>&) const { return false; }
+	};
+}
@@ -0,0 +1,132 @@
+#include "Checksum.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define TK_CRC32C_SSE42 1
+#include <nmmintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define TK_TARGET_SSE42
+#else
+#define TK_TARGET_SSE42 __attribute__((target("sse4.2")))
+#endif
+#endif
+
+namespace TK
+{
+	namespace
+	{
+		struct FCrcTables
+		{
+			std::uint32_t Data[8][256] {};
+		};
+
+		constexpr FCrcTables MakeCrcTables()
+		{
+			constexpr std::uint32_t Polynomial = 0x82F63B78;
+
+			FCrcTables Tables;
+			for (std::uint32_t i = 0; i < 256; ++i)
+			{
+				std::uint32_t Crc = i;
+				for (int Bit = 0; Bit < 8; ++Bit)
+				{
+					Crc = (Crc >> 1) ^ ((Crc & 1) ? Polynomial : 0);
+				}
+				Tables.Data[0][i] = Crc;
+			}
+
+			for (int Slice = 1; Slice < 8; ++Slice)
+			{
+				for (std::uint32_t i = 0; i < 256; ++i)
+				{
+					std::uint32_t Previous = Tables.Data[Slice - 1][i];
+					Tables.Data[Slice][i] = (Previous >> 8) ^ Tables.Data[0][Previous & 0xFF];
+				}
+			}
+			return Tables;
+		}
+
+		constexpr FCrcTables CrcTables = MakeCrcTables();
+
+		std::uint32_t Crc32cPortable(std::uint32_t Crc, const std::uint8_t* Data, std::size_t Length)
+		{
+			const auto& T = CrcTables.Data;
+			while (Length >= 8)
+			{
+				std::uint64_t Word;
+				std::memcpy(&Word, Data, sizeof(Word));
+				Word ^= Crc;
+
+				Crc = T[7][Word & 0xFF] ^ T[6][(Word >> 8) & 0xFF] ^ T[5][(Word >> 16) & 0xFF] ^ T[4][(Word >> 24) & 0xFF] ^
+					T[3][(Word >> 32) & 0xFF] ^ T[2][(Word >> 40) & 0xFF] ^ T[1][(Word >> 48) & 0xFF] ^ T[0][Word >> 56];
+
+				Data += 8;
+				Length -= 8;
+			}
+
+			while (Length-- > 0)
+			{
+				Crc = T[0][(Crc ^ *Data++) & 0xFF] ^ (Crc >> 8);
+			}
+			return Crc;
+		}
+
+#if TK_CRC32C_SSE42
+		TK_TARGET_SSE42 std::uint32_t Crc32cHardware(std::uint32_t Crc, const std::uint8_t* Data, std::size_t Length)
+		{
+			std::uint64_t Crc64 = Crc;
+			while (Length >= 8)
+			{
+				std::uint64_t Word;
+				std::memcpy(&Word, Data, sizeof(Word));
+				Crc64 = _mm_crc32_u64(Crc64, Word);
+
+				Data += 8;
+				Length -= 8;
+			}
+
+			Crc = static_cast<std::uint32_t>(Crc64);
+			while (Length-- > 0)
+			{
+				Crc = _mm_crc32_u8(Crc, *Data++);
+			}
+			return Crc;
+		}
+
+		bool DetectSse42()
+		{
+#if defined(_MSC_VER) && !defined(__clang__)
+			int Info[4];
+			__cpuid(Info, 1);
+			return (Info[2] & (1 << 20)) != 0;
+#else
+			return __builtin_cpu_supports("sse4.2");
+#endif
+		}
+#endif
+	}
+
+	bool IsCrc32cAccelerated()
+	{
+#if TK_CRC32C_SSE42
+		static const bool bSupported = DetectSse42();
+		return bSupported;
+#else
+		return false;
+#endif
+	}
+
+	std::uint32_t Crc32c(const void* Data, std::size_t Length, std::uint32_t Crc)
+	{
+		auto Bytes = static_cast<const std::uint8_t*>(Data);
+		std::uint32_t State = ~Crc;
+
+#if TK_CRC32C_SSE42
+		if (IsCrc32cAccelerated())
+			return ~Crc32cHardware(State, Bytes, Length);
+#endif
+
+		return ~Crc32cPortable(State, Bytes, Length);
+	}
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "Serialization/OutStream.h"
+#include "Serialization/InStream.h"
+#include "Serialization/MemoryReader.h"
+
+namespace TK
+{
+	// CRC32C (Castagnoli). pass the previous result as Crc to continue over more data, 0 starts.
+	// uses the SSE4.2 crc32 instruction when the CPU has it, slicing-by-8 tables otherwise.
+	std::uint32_t Crc32c(const void* Data, std::size_t Length, std::uint32_t Crc = 0);
+
+	// whether Crc32c runs on the SSE4.2 path on this machine.
+	bool IsCrc32cAccelerated();
+
+	// hashes everything pushed through it on the way to Inner. WriteCrc() appends the running
+	// checksum to Inner as a uint32 footer, which TCrcReader::VerifyCrc() checks.
+	template<typename InnerType>
+	class TCrcWriter : public TOutStream<TCrcWriter<InnerType>>
+	{
+		friend class TOutStream<TCrcWriter>;
+
+	public:
+
+		using SizeType = FOutStream::SizeType;
+
+		explicit TCrcWriter(InnerType& InInner) : Inner(InInner) {}
+
+		std::uint32_t GetCrc() const { return Crc; }
+
+		void ResetCrc() { Crc = 0; }
+
+		void WriteCrc()
+		{
+			Inner.Push(&Crc, sizeof(Crc));
+			this->bValidOutput = this->bValidOutput && Inner.IsValidOutput();
+		}
+
+	protected:
+
+		bool PushBytes(const void* Source, SizeType Length)
+		{
+			if (Length <= 0)
+				return true;
+
+			Crc = Crc32c(Source, static_cast<std::size_t>(Length), Crc);
+			Inner.Push(Source, Length);
+			return Inner.IsValidOutput();
+		}
+
+		InnerType& Inner;
+		std::uint32_t Crc {0};
+	};
+
+	template<typename InnerType>
+	class TCrcReader : public TInStream<TCrcReader<InnerType>>
+	{
+		friend class TInStream<TCrcReader>;
+
+	public:
+
+		using SizeType = FInStream::SizeType;
+
+		explicit TCrcReader(InnerType& InInner) : Inner(InInner) {}
+
+		std::uint32_t GetCrc() const { return Crc; }
+
+		void ResetCrc() { Crc = 0; }
+
+		// reads the footer written by TCrcWriter::WriteCrc(), a mismatch marks the input invalid.
+		bool VerifyCrc()
+		{
+			std::uint32_t Expected = 0;
+			Inner.Pop(&Expected, sizeof(Expected));
+
+			if (!Inner.IsValidInput() || Expected != Crc)
+				this->MarkInputInvalid();
+
+			return this->IsValidInput();
+		}
+
+		virtual bool EnsureEnoughBytes(SizeType BytesNum) const override
+		{
+			return Inner.EnsureEnoughBytes(BytesNum);
+		}
+
+	protected:
+
+		bool PopBytes(void* Dest, SizeType Length)
+		{
+			Inner.Pop(Dest, Length);
+			if (!Inner.IsValidInput())
+				return false;
+
+			if (Length > 0)
+				Crc = Crc32c(Dest, static_cast<std::size_t>(Length), Crc);
+			return true;
+		}
+
+		InnerType& Inner;
+		std::uint32_t Crc {0};
+	};
+
+	// checks that the unread bytes of Reader end in a CRC32C of the bytes before it, as
+	// FMessage::AppendChecksum() writes them, and drops the footer from Reader.
+	inline bool StripChecksum(FMemReader& Reader)
+	{
+		constexpr FMemReader::SizeType FooterSize = sizeof(std::uint32_t);
+		if (!Reader.IsValidInput() || Reader.GetUnreadBytes() < FooterSize)
+		{
+			Reader.MarkInputInvalid();
+			return false;
+		}
+
+		auto Begin = static_cast<const char*>(Reader.GetReadPos());
+		FMemReader::SizeType Size = Reader.GetUnreadBytes() - FooterSize;
+
+		std::uint32_t Expected = 0;
+		std::memcpy(&Expected, Begin + Size, sizeof(Expected));
+
+		if (Crc32c(Begin, static_cast<std::size_t>(Size)) != Expected)
+		{
+			Reader.MarkInputInvalid();
+			return false;
+		}
+
+		Reader.Init(Begin, Size);
+		return true;
+	}
+}
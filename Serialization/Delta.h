@@ -0,0 +1,483 @@
+#pragma once
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "Serialization/SerializeFuncs.h"
+
+namespace TK
+{
+	// delta encoding against a baseline both ends already have.
+	//
+	//     TK::SaveDelta(Writer, Current, Acked);
+	//     TK::LoadDelta(Reader, Copy); // Copy holds the same baseline before the call
+	//
+	// TK_SERIAL types write a changed-field mask followed by the changed fields, nested TK_SERIAL
+	// fields recurse, vectors send a changed-element mask plus appended elements and maps send
+	// removed keys plus upserted entries. everything else is resent whole when it differs,
+	// compared with operator==.
+
+	template<typename T, typename = void>
+	inline constexpr bool HasEqualOperator = false;
+
+	template<typename T>
+	inline constexpr bool HasEqualOperator<T, std::void_t<decltype(std::declval<const T&>() == std::declval<const T&>())>> = true;
+
+	template<typename T>
+	bool SerialEqual(const T& A, const T& B);
+
+	template<typename T, std::size_t N>
+	bool SerialEqual(const T(&A)[N], const T(&B)[N]);
+
+	template<typename TupleType, std::size_t... Indices>
+	bool SerialFieldsEqual(const TupleType& A, const TupleType& B, std::index_sequence<Indices...>)
+	{
+		return (SerialEqual(std::get<Indices>(A), std::get<Indices>(B)) && ...);
+	}
+
+	template<typename T, typename = void>
+	inline constexpr bool HasProxyValue = false;
+
+	template<typename T>
+	inline constexpr bool HasProxyValue<T, std::void_t<decltype(std::declval<T&>().Value)>> = IsSerialProxy<T>;
+
+	template<typename T, typename A>
+	bool SerialEqual(const std::vector<T, A>& Left, const std::vector<T, A>& Right)
+	{
+		if (Left.size() != Right.size())
+			return false;
+
+		for (std::size_t i = 0; i < Left.size(); ++i)
+		{
+			if (!SerialEqual(Left[i], Right[i]))
+				return false;
+		}
+		return true;
+	}
+
+	template<typename K, typename V, typename C, typename A>
+	bool SerialEqual(const std::map<K, V, C, A>& Left, const std::map<K, V, C, A>& Right)
+	{
+		if (Left.size() != Right.size())
+			return false;
+
+		for (auto L = Left.begin(), R = Right.begin(); L != Left.end(); ++L, ++R)
+		{
+			if (!(L->first == R->first) || !SerialEqual(L->second, R->second))
+				return false;
+		}
+		return true;
+	}
+
+	template<typename T, std::size_t N>
+	bool SerialEqual(const T(&A)[N], const T(&B)[N])
+	{
+		for (std::size_t i = 0; i < N; ++i)
+		{
+			if (!SerialEqual(A[i], B[i]))
+				return false;
+		}
+		return true;
+	}
+
+	// floats compare bitwise so NaN does not resend forever and -0 is not lost. types with no
+	// SerialFields() and no operator== never compare equal, so they are resent every time.
+	template<typename T>
+	bool SerialEqual(const T& A, const T& B)
+	{
+		if constexpr (HasSerialFields<const T>)
+		{
+			using TupleType = decltype(A.SerialFields());
+			return SerialFieldsEqual(A.SerialFields(), B.SerialFields(), std::make_index_sequence<std::tuple_size_v<TupleType>>{});
+		}
+		else if constexpr (HasProxyValue<T>)
+		{
+			return SerialEqual(A.Value, B.Value);
+		}
+		else if constexpr (std::is_floating_point_v<T>)
+		{
+			return std::memcmp(&A, &B, sizeof(T)) == 0;
+		}
+		else if constexpr (HasEqualOperator<T>)
+		{
+			return A == B;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	// what LoadDelta changed so far, undone newest first when the delta turns out malformed.
+	// fields of the loaded object are logged where they change. container elements and map values
+	// are copied whole before they change and loaded with no log, since their storage can move.
+	class FDeltaUndo
+	{
+	public:
+
+		template<typename FuncType>
+		void Add(FuncType&& Func) { Steps.emplace_back(std::forward<FuncType>(Func)); }
+
+		void Rollback()
+		{
+			for (auto Step = Steps.rbegin(); Step != Steps.rend(); ++Step)
+				(*Step)();
+			Steps.clear();
+		}
+
+	private:
+
+		std::vector<std::function<void()>> Steps;
+	};
+
+	// logs the value Data holds now, when there is a log.
+	template<typename T>
+	void SaveUndo(FDeltaUndo* Undo, T& Data)
+	{
+		if (!Undo)
+			return;
+
+		// C arrays cannot be captured by copy, their elements can
+		if constexpr (std::is_array_v<T>)
+		{
+			for (auto& Element : Data)
+				SaveUndo(Undo, Element);
+		}
+		else
+		{
+			Undo->Add([&Data, Old = Data]() mutable { Data = std::move(Old); });
+		}
+	}
+
+	template<typename StreamType, typename T>
+	void SaveDeltaValue(StreamType& Stream, const T& Current, const T& Baseline);
+
+	template<typename StreamType, typename T>
+	void LoadDeltaValue(StreamType& Stream, T& Data, FDeltaUndo* Undo);
+
+	template<typename StreamType, typename TupleType, std::size_t... Indices>
+	void SaveDeltaFields(StreamType& Stream, const TupleType& Current, const TupleType& Baseline, std::index_sequence<Indices...>)
+	{
+		static_assert(sizeof...(Indices) <= 64, "delta encoding supports at most 64 fields.");
+
+		std::uint64_t Mask = 0;
+		((Mask |= SerialEqual(std::get<Indices>(Current), std::get<Indices>(Baseline)) ? 0 : std::uint64_t(1) << Indices), ...);
+
+		SaveBits(Stream, Mask, static_cast<int>(sizeof...(Indices)));
+		((Mask & (std::uint64_t(1) << Indices) ? SaveDeltaValue(Stream, std::get<Indices>(Current), std::get<Indices>(Baseline)) : void()), ...);
+	}
+
+	template<typename StreamType, typename TupleType, std::size_t... Indices>
+	void LoadDeltaFields(StreamType& Stream, TupleType&& Fields, FDeltaUndo* Undo, std::index_sequence<Indices...>)
+	{
+		constexpr int Num = static_cast<int>(sizeof...(Indices));
+		std::uint64_t Mask = LoadBits(Stream, Num);
+
+		if (!Stream.IsValidInput() || Mask > LowBitsMask(Num))
+		{
+			Stream.MarkInputInvalid();
+			return;
+		}
+
+		((Mask & (std::uint64_t(1) << Indices) ? LoadDeltaValue(Stream, std::get<Indices>(Fields), Undo) : void()), ...);
+	}
+
+	// bit I of the mask is set when element I differs, sent 64 elements per word.
+	template<typename StreamType, typename T, typename A>
+	void SaveDeltaValue(StreamType& Stream, const std::vector<T, A>& Current, const std::vector<T, A>& Baseline)
+	{
+		if (IsSizeOverflow(Current.size()))
+		{
+			Stream.MarkOutputInvalid();
+			TK_ASSERT(false);
+			return;
+		}
+
+		SaveSize(Stream, Current.size());
+
+		const std::size_t Common = Current.size() < Baseline.size() ? Current.size() : Baseline.size();
+		for (std::size_t Start = 0; Start < Common; Start += 64)
+		{
+			int Bits = Common - Start < 64 ? static_cast<int>(Common - Start) : 64;
+			std::uint64_t Mask = 0;
+			for (int i = 0; i < Bits; ++i)
+			{
+				if (!SerialEqual(Current[Start + i], Baseline[Start + i]))
+					Mask |= std::uint64_t(1) << i;
+			}
+
+			SaveBits(Stream, Mask, Bits);
+			for (int i = 0; i < Bits; ++i)
+			{
+				if (Mask & (std::uint64_t(1) << i))
+					SaveDeltaValue(Stream, Current[Start + i], Baseline[Start + i]);
+			}
+		}
+
+		for (std::size_t i = Common; i < Current.size(); ++i)
+		{
+			Save(Stream, Current[i]);
+		}
+	}
+
+	template<typename StreamType, typename T, typename A>
+	void LoadDeltaValue(StreamType& Stream, std::vector<T, A>& Data, FDeltaUndo* Undo)
+	{
+		std::uint32_t Num = LoadSize(Stream);
+		if (!Stream.IsValidInput())
+			return;
+
+		const std::size_t Common = Num < Data.size() ? Num : Data.size();
+		const std::uint64_t Added = Num - Common;
+
+		// appended elements take at least their fixed size on byte streams, and a bit otherwise
+		std::uint64_t MinBytes = (Added + 7) / 8;
+		if constexpr (!IsBitStream<StreamType> && FixedEncodedSize<T> > 0)
+		{
+			if (!TFixedSize<T>::bIntegers || Stream.GetIntEncoding() == EIntEncoding::Fixed)
+				MinBytes = Added * FixedEncodedSize<T>;
+		}
+
+		if (!Stream.EnsureEnoughBytes(MinBytes))
+		{
+			Stream.MarkInputInvalid();
+			return;
+		}
+
+		for (std::size_t Start = 0; Start < Common; Start += 64)
+		{
+			int Bits = Common - Start < 64 ? static_cast<int>(Common - Start) : 64;
+			std::uint64_t Mask = LoadBits(Stream, Bits);
+			if (!Stream.IsValidInput() || Mask > LowBitsMask(Bits))
+			{
+				Stream.MarkInputInvalid();
+				return;
+			}
+
+			for (int i = 0; i < Bits; ++i)
+			{
+				if (!(Mask & (std::uint64_t(1) << i)))
+					continue;
+
+				// by index, growing below may move the elements
+				const std::size_t Index = Start + i;
+				if (Undo)
+					Undo->Add([&Data, Index, Old = Data[Index]]() mutable { Data[Index] = std::move(Old); });
+
+				LoadDeltaValue(Stream, Data[Index], nullptr);
+			}
+		}
+
+		// shrinks at once, but grows one element at a time so a bogus count cannot allocate ahead
+		if (Num < Data.size())
+		{
+			if (Undo)
+			{
+				std::vector<T, A> Tail(std::make_move_iterator(Data.begin() + Num), std::make_move_iterator(Data.end()), Data.get_allocator());
+				Undo->Add([&Data, Tail = std::move(Tail)]() mutable
+				{
+					Data.insert(Data.end(), std::make_move_iterator(Tail.begin()), std::make_move_iterator(Tail.end()));
+				});
+			}
+			Data.resize(Num);
+		}
+
+		if (Undo && Data.size() < Num)
+		{
+			const std::size_t OldSize = Data.size();
+			Undo->Add([&Data, OldSize]() { Data.erase(Data.begin() + OldSize, Data.end()); });
+		}
+
+		while (Data.size() < Num && Stream.IsValidInput())
+		{
+			Load(Stream, Data.emplace_back());
+		}
+	}
+
+	template<typename StreamType, typename A>
+	void SaveDeltaValue(StreamType& Stream, const std::vector<bool, A>& Current, const std::vector<bool, A>&)
+	{
+		Save(Stream, Current);
+	}
+
+	template<typename StreamType, typename A>
+	void LoadDeltaValue(StreamType& Stream, std::vector<bool, A>& Data, FDeltaUndo* Undo)
+	{
+		SaveUndo(Undo, Data);
+		Load(Stream, Data);
+	}
+
+	template<typename StreamType, typename K, typename V, typename C, typename A>
+	void SaveDeltaValue(StreamType& Stream, const std::map<K, V, C, A>& Current, const std::map<K, V, C, A>& Baseline)
+	{
+		std::vector<const K*> Removed;
+		std::vector<const typename std::map<K, V, C, A>::value_type*> Upserted;
+
+		for (const auto& Pair : Baseline)
+		{
+			if (Current.find(Pair.first) == Current.end())
+				Removed.push_back(&Pair.first);
+		}
+
+		for (const auto& Pair : Current)
+		{
+			auto Found = Baseline.find(Pair.first);
+			if (Found == Baseline.end() || !SerialEqual(Pair.second, Found->second))
+				Upserted.push_back(&Pair);
+		}
+
+		SaveSize(Stream, Removed.size());
+		for (const K* Key : Removed)
+		{
+			Save(Stream, *Key);
+		}
+
+		SaveSize(Stream, Upserted.size());
+		for (const auto* Pair : Upserted)
+		{
+			Save(Stream, Pair->first);
+
+			auto Found = Baseline.find(Pair->first);
+			bool bExisted = Found != Baseline.end();
+			Save(Stream, bExisted);
+
+			if (bExisted)
+			{
+				SaveDeltaValue(Stream, Pair->second, Found->second);
+			}
+			else
+			{
+				Save(Stream, Pair->second);
+			}
+		}
+	}
+
+	template<typename StreamType, typename K, typename V, typename C, typename A>
+	void LoadDeltaValue(StreamType& Stream, std::map<K, V, C, A>& Data, FDeltaUndo* Undo)
+	{
+		std::uint32_t RemovedNum = LoadSize(Stream);
+		for (std::uint32_t i = 0; i < RemovedNum && Stream.IsValidInput(); ++i)
+		{
+			K Key {};
+			Load(Stream, Key);
+			if (!Stream.IsValidInput())
+				return;
+
+			auto Found = Data.find(Key);
+			if (Found == Data.end())
+			{
+				Stream.MarkInputInvalid();
+				return;
+			}
+
+			auto Node = Data.extract(Found);
+			if (Undo)
+			{
+				Undo->Add([&Data, Entry = std::pair<K, V>(std::move(Node.key()), std::move(Node.mapped()))]() mutable
+				{
+					Data.emplace(std::move(Entry.first), std::move(Entry.second));
+				});
+			}
+		}
+
+		std::uint32_t UpsertedNum = LoadSize(Stream);
+		for (std::uint32_t i = 0; i < UpsertedNum && Stream.IsValidInput(); ++i)
+		{
+			K Key {};
+			bool bExisted = false;
+			Load(Stream, Key);
+			Load(Stream, bExisted);
+
+			if (!Stream.IsValidInput())
+				return;
+
+			auto Found = Data.find(Key);
+			if (bExisted != (Found != Data.end()))
+			{
+				Stream.MarkInputInvalid();
+				return;
+			}
+
+			if (bExisted)
+			{
+				SaveUndo(Undo, Found->second);
+				LoadDeltaValue(Stream, Found->second, nullptr);
+			}
+			else
+			{
+				V Value {};
+				Load(Stream, Value);
+				if (!Stream.IsValidInput())
+					return;
+
+				auto Inserted = Data.emplace(std::move(Key), std::move(Value)).first;
+				if (Undo)
+					Undo->Add([&Data, Inserted]() { Data.erase(Inserted); });
+			}
+		}
+	}
+
+	template<typename StreamType, typename T>
+	void SaveDeltaValue(StreamType& Stream, const T& Current, const T& Baseline)
+	{
+		if constexpr (HasSerialFields<const T>)
+		{
+			using TupleType = decltype(Current.SerialFields());
+			SaveDeltaFields(Stream, Current.SerialFields(), Baseline.SerialFields(), std::make_index_sequence<std::tuple_size_v<TupleType>>{});
+		}
+		else
+		{
+			Save(Stream, Current);
+		}
+	}
+
+	// with no Undo the caller has a copy of Data to go back to.
+	template<typename StreamType, typename T>
+	void LoadDeltaValue(StreamType& Stream, T& Data, FDeltaUndo* Undo)
+	{
+		if constexpr (HasSerialFields<T>)
+		{
+			using TupleType = decltype(Data.SerialFields());
+			LoadDeltaFields(Stream, Data.SerialFields(), Undo, std::make_index_sequence<std::tuple_size_v<TupleType>>{});
+		}
+		else
+		{
+			// proxies are temporaries, the field they stand for is what gets logged
+			if constexpr (HasProxyValue<T>)
+			{
+				SaveUndo(Undo, Data.Value);
+			}
+			else
+			{
+				SaveUndo(Undo, Data);
+			}
+			Load(Stream, Data);
+		}
+	}
+
+	template<typename StreamType, typename T, std::enable_if_t<IsOutStream<StreamType>>* = nullptr>
+	void SaveDelta(StreamType& Stream, const T& Current, const T& Baseline)
+	{
+		SaveDeltaValue(Stream, Current, Baseline);
+	}
+
+	// Data must hold the baseline the writer used. the delta is applied in place and what it
+	// touched is logged, so a malformed one is rolled back and leaves the baseline intact while a
+	// good one costs only the copies of the values it changed.
+	template<typename StreamType, typename T, std::enable_if_t<IsInStream<StreamType>>* = nullptr>
+	void LoadDelta(StreamType& Stream, T& Data)
+	{
+		if (!Stream.IsValidInput())
+			return;
+
+		FDeltaUndo Undo;
+		LoadDeltaValue(Stream, Data, &Undo);
+
+		if (!Stream.IsValidInput())
+			Undo.Rollback();
+	}
+}
@@ -0,0 +1,338 @@
+#include "FileStream.h"
+#include <new>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+namespace TK
+{
+	namespace
+	{
+		constexpr std::size_t MaxIOChunk = 1 << 30;
+
+		char* AllocateBuffer(std::size_t& Capacity)
+		{
+			constexpr std::size_t Alignment = FFileWriter::DirectAlignment;
+			Capacity = Capacity < Alignment ? Alignment : (Capacity + Alignment - 1) / Alignment * Alignment;
+			return static_cast<char*>(::operator new(Capacity, std::align_val_t(Alignment)));
+		}
+
+		void FreeBuffer(char* Buffer)
+		{
+			::operator delete(Buffer, std::align_val_t(FFileWriter::DirectAlignment));
+		}
+
+#ifdef _WIN32
+		int OpenFile(const char* Path, bool bWrite, bool /*bDirectIO*/, bool& bDirect)
+		{
+			bDirect = false;
+			return bWrite ? _open(Path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE)
+				: _open(Path, _O_RDONLY | _O_BINARY);
+		}
+
+		void CloseFile(int Handle) { _close(Handle); }
+
+		std::int64_t ReadFile(int Handle, char* Dest, std::size_t Length)
+		{
+			return _read(Handle, Dest, static_cast<unsigned int>(Length < MaxIOChunk ? Length : MaxIOChunk));
+		}
+
+		std::int64_t WriteFile(int Handle, const char* Source, std::size_t Length)
+		{
+			return _write(Handle, Source, static_cast<unsigned int>(Length < MaxIOChunk ? Length : MaxIOChunk));
+		}
+
+		std::uint64_t QueryFileSize(int Handle)
+		{
+			struct _stat64 Stat;
+			return _fstat64(Handle, &Stat) == 0 ? static_cast<std::uint64_t>(Stat.st_size) : 0;
+		}
+
+		void DisableDirectIO(int) {}
+
+		void AdviseSequential(int) {}
+#else
+		int OpenFile(const char* Path, bool bWrite, bool bDirectIO, bool& bDirect)
+		{
+			int Flags = bWrite ? O_WRONLY | O_CREAT | O_TRUNC : O_RDONLY;
+			bDirect = false;
+
+#if defined(O_DIRECT)
+			if (bDirectIO)
+			{
+				int Handle = open(Path, Flags | O_DIRECT, 0644);
+				if (Handle >= 0)
+				{
+					bDirect = true;
+					return Handle;
+				}
+
+				// tmpfs and some network file systems refuse O_DIRECT, those get buffered I/O.
+				if (errno != EINVAL)
+					return -1;
+			}
+#endif
+
+			int Handle = open(Path, Flags, 0644);
+
+#if defined(F_NOCACHE)
+			if (Handle >= 0 && bDirectIO)
+				bDirect = fcntl(Handle, F_NOCACHE, 1) == 0;
+#endif
+			return Handle;
+		}
+
+		void CloseFile(int Handle) { close(Handle); }
+
+		std::int64_t ReadFile(int Handle, char* Dest, std::size_t Length)
+		{
+			ssize_t Result;
+			do
+			{
+				Result = read(Handle, Dest, Length < MaxIOChunk ? Length : MaxIOChunk);
+			}
+			while (Result < 0 && errno == EINTR);
+			return Result;
+		}
+
+		std::int64_t WriteFile(int Handle, const char* Source, std::size_t Length)
+		{
+			ssize_t Result;
+			do
+			{
+				Result = write(Handle, Source, Length < MaxIOChunk ? Length : MaxIOChunk);
+			}
+			while (Result < 0 && errno == EINTR);
+			return Result;
+		}
+
+		std::uint64_t QueryFileSize(int Handle)
+		{
+			struct stat Stat;
+			return fstat(Handle, &Stat) == 0 ? static_cast<std::uint64_t>(Stat.st_size) : 0;
+		}
+
+		// O_DIRECT writes must be whole blocks, the unaligned tail of a file goes out buffered.
+		void DisableDirectIO(int Handle)
+		{
+#if defined(O_DIRECT)
+			int Flags = fcntl(Handle, F_GETFL);
+			if (Flags >= 0)
+				fcntl(Handle, F_SETFL, Flags & ~O_DIRECT);
+#endif
+		}
+
+		void AdviseSequential(int Handle)
+		{
+#if defined(POSIX_FADV_SEQUENTIAL)
+			posix_fadvise(Handle, 0, 0, POSIX_FADV_SEQUENTIAL);
+			posix_fadvise(Handle, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+		}
+#endif
+
+		bool WriteAll(int Handle, const char* Source, std::size_t Length)
+		{
+			while (Length > 0)
+			{
+				std::int64_t Result = WriteFile(Handle, Source, Length);
+				if (Result <= 0)
+					return false;
+
+				Source += Result;
+				Length -= static_cast<std::size_t>(Result);
+			}
+			return true;
+		}
+
+		std::size_t ReadAll(int Handle, char* Dest, std::size_t Length)
+		{
+			std::size_t Total = 0;
+			while (Total < Length)
+			{
+				std::int64_t Result = ReadFile(Handle, Dest + Total, Length - Total);
+				if (Result <= 0)
+					break;
+
+				Total += static_cast<std::size_t>(Result);
+			}
+			return Total;
+		}
+	}
+
+	FFileWriter::FFileWriter(std::size_t BufferSize) : Capacity(BufferSize)
+	{
+		Buffer = AllocateBuffer(Capacity);
+		bValidOutput = false;
+	}
+
+	FFileWriter::~FFileWriter()
+	{
+		Close();
+		FreeBuffer(Buffer);
+	}
+
+	bool FFileWriter::Open(const char* Path, bool bDirectIO)
+	{
+		Close();
+
+		Handle = OpenFile(Path, true, bDirectIO, bDirect);
+		Used = 0;
+		Written = 0;
+		bValidOutput = Handle >= 0;
+		return bValidOutput;
+	}
+
+	bool FFileWriter::Close()
+	{
+		if (Handle < 0)
+			return false;
+
+		if (bDirect && Used % DirectAlignment != 0)
+			DisableDirectIO(Handle);
+
+		bool bSucceeded = bValidOutput && WriteBuffer();
+
+		CloseFile(Handle);
+		Handle = -1;
+		bValidOutput = false;
+		return bSucceeded;
+	}
+
+	bool FFileWriter::WriteBuffer()
+	{
+		if (!WriteAll(Handle, Buffer, Used))
+			return false;
+
+		Written += Used;
+		Used = 0;
+		return true;
+	}
+
+	bool FFileWriter::PushSlow(const char* Source, SizeType Length)
+	{
+		if (Handle < 0)
+			return false;
+
+		auto Remained = static_cast<std::uint64_t>(Length);
+		while (Remained > 0)
+		{
+			if (Used == Capacity && !WriteBuffer())
+				return false;
+
+			// large payloads skip the copy when nothing is pending and alignment does not matter
+			if (Used == 0 && !bDirect && Remained >= Capacity)
+			{
+				if (!WriteAll(Handle, Source, static_cast<std::size_t>(Remained)))
+					return false;
+
+				Written += Remained;
+				return true;
+			}
+
+			std::size_t Chunk = Capacity - Used < Remained ? Capacity - Used : static_cast<std::size_t>(Remained);
+			std::memcpy(Buffer + Used, Source, Chunk);
+
+			Used += Chunk;
+			Source += Chunk;
+			Remained -= Chunk;
+		}
+		return true;
+	}
+
+	FFileReader::FFileReader(std::size_t BufferSize) : Capacity(BufferSize)
+	{
+		Buffer = AllocateBuffer(Capacity);
+		bValidInput = false;
+	}
+
+	FFileReader::~FFileReader()
+	{
+		Close();
+		FreeBuffer(Buffer);
+	}
+
+	bool FFileReader::Open(const char* Path, bool bDirectIO)
+	{
+		Close();
+
+		Handle = OpenFile(Path, false, bDirectIO, bDirect);
+		Filled = 0;
+		Offset = 0;
+		FileOffset = 0;
+		FileSize = Handle >= 0 ? QueryFileSize(Handle) : 0;
+
+		if (Handle >= 0)
+			AdviseSequential(Handle);
+
+		bValidInput = Handle >= 0;
+		return bValidInput;
+	}
+
+	void FFileReader::Close()
+	{
+		if (Handle >= 0)
+			CloseFile(Handle);
+
+		Handle = -1;
+		FileSize = 0;
+		FileOffset = 0;
+		Filled = 0;
+		Offset = 0;
+		bValidInput = false;
+	}
+
+	// one read per refill keeps O_DIRECT offsets block aligned, only the last block comes back short.
+	bool FFileReader::Refill()
+	{
+		Offset = 0;
+		Filled = 0;
+
+		std::int64_t Result = ReadFile(Handle, Buffer, Capacity);
+		if (Result <= 0)
+			return false;
+
+		Filled = static_cast<std::size_t>(Result);
+		FileOffset += Filled;
+		return true;
+	}
+
+	bool FFileReader::PopSlow(char* Dest, SizeType Length)
+	{
+		if (Handle < 0 || !EnsureEnoughBytes(Length))
+			return false;
+
+		auto Remained = static_cast<std::uint64_t>(Length);
+		while (Remained > 0)
+		{
+			if (Offset == Filled)
+			{
+				if (!bDirect && Remained >= Capacity)
+				{
+					std::size_t Got = ReadAll(Handle, Dest, static_cast<std::size_t>(Remained));
+					FileOffset += Got;
+					return Got == Remained;
+				}
+
+				if (!Refill())
+					return false;
+			}
+
+			std::size_t Chunk = Filled - Offset < Remained ? Filled - Offset : static_cast<std::size_t>(Remained);
+			std::memcpy(Dest, Buffer + Offset, Chunk);
+
+			Offset += Chunk;
+			Dest += Chunk;
+			Remained -= Chunk;
+		}
+		return true;
+	}
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "Serialization/OutStream.h"
+#include "Serialization/InStream.h"
+
+namespace TK
+{
+	// streams Save()/Load() straight to and from a file through a large buffer, so snapshots never
+	// have to fit in memory. Open() with bDirectIO asks for O_DIRECT (F_NOCACHE on macOS) and
+	// falls back to buffered I/O where the file system refuses it. the buffer is page aligned and
+	// a multiple of DirectAlignment either way.
+	class FFileWriter : public TOutStream<FFileWriter>
+	{
+		friend class TOutStream<FFileWriter>;
+
+	public:
+
+		static constexpr std::size_t DefaultBufferSize = 1 << 20;
+		static constexpr std::size_t DirectAlignment = 4096;
+
+		explicit FFileWriter(std::size_t BufferSize = DefaultBufferSize);
+		~FFileWriter() override;
+
+		FFileWriter(const FFileWriter&) = delete;
+		FFileWriter& operator=(const FFileWriter&) = delete;
+
+		// truncates or creates Path.
+		bool Open(const char* Path, bool bDirectIO = false);
+
+		// flushes and closes, returns false if any write failed.
+		bool Close();
+
+		bool IsOpen() const { return Handle >= 0; }
+
+		bool IsDirectIO() const { return bDirect; }
+
+		std::uint64_t GetSize() const { return Written + Used; }
+
+	protected:
+
+		bool PushBytes(const void* Source, SizeType Length)
+		{
+			if (Length <= 0)
+				return true;
+
+			if (static_cast<std::uint64_t>(Length) <= Capacity - Used)
+			{
+				std::memcpy(Buffer + Used, Source, static_cast<std::size_t>(Length));
+				Used += static_cast<std::size_t>(Length);
+				return true;
+			}
+			return PushSlow(static_cast<const char*>(Source), Length);
+		}
+
+		bool PushSlow(const char* Source, SizeType Length);
+
+		bool WriteBuffer();
+
+		int Handle {-1};
+		char* Buffer {nullptr};
+		std::size_t Capacity {0};
+		std::size_t Used {0};
+		std::uint64_t Written {0};
+		bool bDirect {false};
+	};
+
+	class FFileReader : public TInStream<FFileReader>
+	{
+		friend class TInStream<FFileReader>;
+
+	public:
+
+		static constexpr std::size_t DefaultBufferSize = FFileWriter::DefaultBufferSize;
+
+		explicit FFileReader(std::size_t BufferSize = DefaultBufferSize);
+		~FFileReader() override;
+
+		FFileReader(const FFileReader&) = delete;
+		FFileReader& operator=(const FFileReader&) = delete;
+
+		// hints sequential access to the kernel where posix_fadvise exists.
+		bool Open(const char* Path, bool bDirectIO = false);
+
+		void Close();
+
+		bool IsOpen() const { return Handle >= 0; }
+
+		bool IsDirectIO() const { return bDirect; }
+
+		std::uint64_t GetFileSize() const { return FileSize; }
+
+		std::uint64_t GetUnreadBytes() const { return FileSize - FileOffset + (Filled - Offset); }
+
+		virtual bool EnsureEnoughBytes(SizeType BytesNum) const override
+		{
+			return BytesNum >= 0 && GetUnreadBytes() >= static_cast<std::uint64_t>(BytesNum);
+		}
+
+	protected:
+
+		bool PopBytes(void* Dest, SizeType Length)
+		{
+			if (Length < 0)
+				return false;
+
+			if (static_cast<std::uint64_t>(Length) <= Filled - Offset)
+			{
+				std::memcpy(Dest, Buffer + Offset, static_cast<std::size_t>(Length));
+				Offset += static_cast<std::size_t>(Length);
+				return true;
+			}
+			return PopSlow(static_cast<char*>(Dest), Length);
+		}
+
+		bool PopSlow(char* Dest, SizeType Length);
+
+		bool Refill();
+
+		int Handle {-1};
+		char* Buffer {nullptr};
+		std::size_t Capacity {0};
+		std::size_t Filled {0};
+		std::size_t Offset {0};
+		std::uint64_t FileSize {0};
+		std::uint64_t FileOffset {0};
+		bool bDirect {false};
+	};
+}
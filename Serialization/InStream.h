@@ -1,6 +1,7 @@
 ﻿#pragma once
 #include <cstdint>
 #include <type_traits>	// ReSharper disable once CppUnusedIncludeDirective, false positive
+#include "Serialization/Varint.h"
 
 namespace TK
 {
@@ -48,6 +49,16 @@ namespace TK
 		bool IsValidInput() const { return bValidInput; }
 
 		void MarkInputInvalid() { bValidInput = false; }
+
+		void SetIntEncoding(EIntEncoding Encoding) { IntEncoding = Encoding; }
+
+		EIntEncoding GetIntEncoding() const { return IntEncoding; }
+
+		// containers then load over the elements and map nodes they already hold, so decoding into
+		// the same object again keeps its allocations. elements must load every field they keep.
+		void SetReuseContainers(bool bReuse) { bReuseContainers = bReuse; }
+
+		bool IsReusingContainers() const { return bReuseContainers; }
 		
 		virtual bool EnsureEnoughBytes(SizeType BytesNum) const = 0;
 	
@@ -56,6 +67,50 @@ namespace TK
 		virtual bool PopImpl(void* Dest, SizeType Length) = 0;
 
 		bool bValidInput{true};
+		EIntEncoding IntEncoding{EIntEncoding::Fixed};
+		bool bReuseContainers{false};
+	};
+
+	// compile-time dispatched counterpart of TOutStream. concrete streams provide
+	// bool PopBytes(void*, SizeType).
+	template<typename DerivedType>
+	class TInStream : public FInStream
+	{
+	public:
+
+		void Pop(void* Dest, SizeType Length)
+		{
+			if (bValidInput)
+				bValidInput = static_cast<DerivedType*>(this)->PopBytes(Dest, Length);
+		}
+
+		template <typename T, typename U, std::enable_if_t<std::is_integral_v<T>>* = nullptr>
+		void PopAs(U& Data)
+		{
+			T Value;
+			Pop(&Value, sizeof(T));
+
+			if (bValidInput)
+				Data = static_cast<U>(Value);
+		}
+
+		template <typename T>
+		T Pop()
+		{
+			T Value{};
+
+			if (bValidInput)
+				static_cast<DerivedType&>(*this) & Value;
+
+			return Value;
+		}
+
+	protected:
+
+		virtual bool PopImpl(void* Dest, SizeType Length) override final
+		{
+			return static_cast<DerivedType*>(this)->PopBytes(Dest, Length);
+		}
 	};
 
 #define TK_CHECK_INPUT(Stream) if (!(Stream).IsValidInput()) return;
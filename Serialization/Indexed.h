@@ -0,0 +1,366 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Serialization/LengthSlot.h"
+#include "Serialization/LimitedReader.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/SerializeFuncs.h"
+
+namespace TK
+{
+	// TK::Indexed(Field) inside TK_SERIAL for a std::vector or std::map. the container is saved
+	// as its size, a uint32 end offset per element and the elements, map entries sorted by key.
+	// loading it into the container decodes everything as usual, loading it into a
+	// TIndexedVectorView or TIndexedMapView from an FMemReader decodes only what is asked for.
+	template<typename T>
+	struct TIndexedRef
+	{
+		T& Value;
+	};
+
+	template<typename T>
+	TIndexedRef<T> Indexed(T& Value)
+	{
+		return TIndexedRef<T>{Value};
+	}
+
+	template<typename T>
+	inline constexpr bool IsSerialProxy<TIndexedRef<T>> = true;
+
+	// strings are looked up and compared as views into the buffer, other keys as themselves.
+	template<typename K>
+	struct TIndexKey
+	{
+		using Type = K;
+	};
+
+	template<typename CharType>
+	struct TIndexKey<std::basic_string<CharType>>
+	{
+		using Type = std::basic_string_view<CharType>;
+	};
+
+	template<typename StreamType, typename ItemType, typename SaveFuncType>
+	void SaveIndexed(StreamType& Stream, const ItemType& Items, SaveFuncType&& SaveItem)
+	{
+		static_assert(!IsBitStream<StreamType>, "indexed containers need a byte stream.");
+
+		if (IsSizeOverflow(Items.size()))
+		{
+			Stream.MarkOutputInvalid();
+			TK_ASSERT(false);
+			return;
+		}
+
+		// the table is reserved and each end offset filled in once its element is written.
+		if constexpr (CanBackfill<StreamType>)
+		{
+			SaveSize(Stream, Items.size());
+
+			const std::size_t Table = Stream.GetSize();
+			const char Zeros[256] {};
+			for (std::size_t Left = Items.size() * sizeof(std::uint32_t); Left > 0;)
+			{
+				std::size_t Chunk = Left < sizeof(Zeros) ? Left : sizeof(Zeros);
+				Stream.Push(Zeros, Chunk);
+				Left -= Chunk;
+			}
+
+			const std::size_t Begin = Stream.GetSize();
+			std::size_t Index = 0;
+			for (const auto& Item : Items)
+			{
+				SaveItem(Stream, Item);
+				if (!Stream.IsValidOutput())
+					return;
+
+				if (IsSizeOverflow(Stream.GetSize() - Begin))
+				{
+					Stream.MarkOutputInvalid();
+					TK_ASSERT(false);
+					return;
+				}
+
+				auto End = static_cast<std::uint32_t>(Stream.GetSize() - Begin);
+				Stream.Overwrite(Table + Index++ * sizeof(std::uint32_t), &End, sizeof(End));
+			}
+		}
+		else
+		{
+			// FFileWriter, TLZWriter and TCrcWriter pass bytes on and cannot rewrite them, the
+			// elements are staged to know the table first.
+			TMemWriter<0> Entries;
+			Entries.SetIntEncoding(Stream.GetIntEncoding());
+
+			std::vector<std::uint32_t> Ends;
+			Ends.reserve(Items.size());
+
+			for (const auto& Item : Items)
+			{
+				SaveItem(Entries, Item);
+				if (IsSizeOverflow(Entries.GetSize()))
+				{
+					Stream.MarkOutputInvalid();
+					TK_ASSERT(false);
+					return;
+				}
+
+				Ends.push_back(static_cast<std::uint32_t>(Entries.GetSize()));
+			}
+
+			if (!Entries.IsValidOutput())
+			{
+				Stream.MarkOutputInvalid();
+				return;
+			}
+
+			SaveSize(Stream, Items.size());
+			Stream.Push(Ends.data(), Ends.size() * sizeof(std::uint32_t));
+			Stream.Push(Entries.GetBuffer(), Entries.GetSize());
+		}
+	}
+
+	// calls LoadItem(Stream, Length) once per element in order, with the element's byte length.
+	template<typename StreamType, typename LoadFuncType>
+	void LoadIndexed(StreamType& Stream, LoadFuncType&& LoadItem)
+	{
+		static_assert(!IsBitStream<StreamType>, "indexed containers need a byte stream.");
+
+		if (!Stream.IsValidInput())
+			return;
+
+		std::uint32_t Num = LoadSize(Stream);
+		if (!Stream.EnsureEnoughBytes(static_cast<std::uint64_t>(Num) * sizeof(std::uint32_t)))
+		{
+			Stream.MarkInputInvalid();
+			return;
+		}
+
+		if (Num == 0)
+			return;
+
+		std::vector<std::uint32_t> Ends(Num);
+		Stream.Pop(Ends.data(), Num * sizeof(std::uint32_t));
+
+		std::uint32_t Begin = 0;
+		for (std::uint32_t i = 0; i < Num && Stream.IsValidInput(); ++i)
+		{
+			if (Ends[i] < Begin)
+			{
+				Stream.MarkInputInvalid();
+				return;
+			}
+
+			LoadItem(Stream, Ends[i] - Begin);
+			Begin = Ends[i];
+		}
+	}
+
+	template<typename StreamType, typename T, std::enable_if_t<IsOutStream<StreamType>>* = nullptr>
+	void Save(StreamType& Stream, const TIndexedRef<T>& Data)
+	{
+		SaveIndexed(Stream, Data.Value, [](auto& Entries, const auto& Item) { Entries & Item; });
+	}
+
+	template<typename StreamType, typename T, std::enable_if_t<IsInStream<StreamType>>* = nullptr>
+	void Load(StreamType& Stream, const TIndexedRef<std::vector<T>>& Data)
+	{
+		Data.Value.clear();
+		LoadIndexed(Stream, [&](StreamType& Source, std::uint32_t Length)
+		{
+			T Item {};
+			LoadBounded(Source, Item, Length);
+
+			if (Source.IsValidInput())
+				Data.Value.push_back(std::move(Item));
+		});
+	}
+
+	template<typename StreamType, typename K, typename V, std::enable_if_t<IsInStream<StreamType>>* = nullptr>
+	void Load(StreamType& Stream, const TIndexedRef<std::map<K, V>>& Data)
+	{
+		Data.Value.clear();
+		LoadIndexed(Stream, [&](StreamType& Source, std::uint32_t Length)
+		{
+			std::pair<K, V> Entry {};
+			LoadBounded(Source, Entry, Length);
+
+			if (Source.IsValidInput() && !Data.Value.emplace(std::move(Entry)).second)
+				Source.MarkInputInvalid();
+		});
+	}
+
+	// the offset table and element bytes of an indexed container, left in the reader's buffer.
+	// the buffer has to outlive the view.
+	class FIndexedView
+	{
+	public:
+
+		std::uint32_t GetSize() const { return Num; }
+
+		bool IsEmpty() const { return Num == 0; }
+
+		template<typename StreamType>
+		void LoadTable(StreamType& Stream)
+		{
+			static_assert(IsMemReader<StreamType>, "indexed views can only be loaded from an FMemReader.");
+
+			*this = FIndexedView();
+			if (!Stream.IsValidInput())
+				return;
+
+			std::uint32_t Count = LoadSize(Stream);
+			if (!Stream.EnsureEnoughBytes(static_cast<std::uint64_t>(Count) * sizeof(std::uint32_t)))
+			{
+				Stream.MarkInputInvalid();
+				return;
+			}
+
+			auto Table = static_cast<const char*>(Stream.GetReadPos());
+			std::uint32_t Size = 0;
+			if (Count > 0)
+				std::memcpy(&Size, Table + (Count - 1) * sizeof(std::uint32_t), sizeof(Size));
+
+			Stream.Advance(Count * sizeof(std::uint32_t));
+			if (!Stream.EnsureEnoughBytes(Size))
+			{
+				Stream.MarkInputInvalid();
+				return;
+			}
+
+			Ends = Table;
+			Entries = static_cast<const char*>(Stream.GetReadPos());
+			Num = Count;
+			EntriesSize = Size;
+			IntEncoding = Stream.GetIntEncoding();
+			Stream.Advance(Size);
+		}
+
+	protected:
+
+		// a reader over element Index alone, invalid when the table is malformed.
+		FMemReader GetEntry(std::uint32_t Index) const
+		{
+			std::uint32_t Begin = Index > 0 ? GetEnd(Index - 1) : 0;
+			std::uint32_t End = GetEnd(Index);
+
+			FMemReader Entry;
+			if (Begin > End || End > EntriesSize)
+			{
+				Entry.MarkInputInvalid();
+				return Entry;
+			}
+
+			Entry.Init(Entries + Begin, End - Begin);
+			Entry.SetIntEncoding(IntEncoding);
+			return Entry;
+		}
+
+		std::uint32_t GetEnd(std::uint32_t Index) const
+		{
+			std::uint32_t End;
+			std::memcpy(&End, Ends + Index * sizeof(std::uint32_t), sizeof(End));
+			return End;
+		}
+
+		const char* Ends {nullptr};
+		const char* Entries {nullptr};
+		std::uint32_t Num {0};
+		std::uint32_t EntriesSize {0};
+		EIntEncoding IntEncoding {EIntEncoding::Fixed};
+	};
+
+	// random access into a TK::Indexed vector without decoding the rest.
+	template<typename T>
+	class TIndexedVectorView : public FIndexedView
+	{
+	public:
+
+		// false when Index is out of range or the element does not decode exactly.
+		bool Get(std::uint32_t Index, T& Item) const
+		{
+			if (Index >= Num)
+				return false;
+
+			FMemReader Entry = GetEntry(Index);
+			Entry & Item;
+			return Entry.IsValidInput() && Entry.GetUnreadBytes() == 0;
+		}
+	};
+
+	// binary searches a TK::Indexed map, decoding one key per step and only the matching value.
+	template<typename K, typename V>
+	class TIndexedMapView : public FIndexedView
+	{
+	public:
+
+		using KeyType = typename TIndexKey<K>::Type;
+
+		bool Find(const KeyType& Key, V& Value) const
+		{
+			FMemReader Entry;
+			if (!FindEntry(Key, Entry))
+				return false;
+
+			Entry & Value;
+			return Entry.IsValidInput() && Entry.GetUnreadBytes() == 0;
+		}
+
+		bool Contains(const KeyType& Key) const
+		{
+			FMemReader Entry;
+			return FindEntry(Key, Entry);
+		}
+
+	protected:
+
+		// leaves Entry right after the matching key.
+		bool FindEntry(const KeyType& Key, FMemReader& Entry) const
+		{
+			std::uint32_t Low = 0;
+			std::uint32_t High = Num;
+
+			while (Low < High)
+			{
+				std::uint32_t Middle = Low + (High - Low) / 2;
+				Entry = GetEntry(Middle);
+
+				KeyType Current {};
+				Entry & Current;
+				if (!Entry.IsValidInput())
+					return false;
+
+				if (Current < Key)
+				{
+					Low = Middle + 1;
+				}
+				else if (Key < Current)
+				{
+					High = Middle;
+				}
+				else
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+	};
+
+	template<typename StreamType, typename T, std::enable_if_t<IsMemReader<StreamType>>* = nullptr>
+	void Load(StreamType& Stream, TIndexedVectorView<T>& Data)
+	{
+		Data.LoadTable(Stream);
+	}
+
+	template<typename StreamType, typename K, typename V, std::enable_if_t<IsMemReader<StreamType>>* = nullptr>
+	void Load(StreamType& Stream, TIndexedMapView<K, V>& Data)
+	{
+		Data.LoadTable(Stream);
+	}
+}
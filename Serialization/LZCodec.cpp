@@ -0,0 +1,200 @@
+#include "LZCodec.h"
+#include <cstdint>
+#include <cstring>
+
+namespace TK
+{
+	namespace
+	{
+		constexpr int MinMatch = 4;
+		constexpr int HashBits = 12;
+		constexpr int LastLiterals = 5;
+		constexpr int MatchFindLimit = 12;
+		constexpr std::size_t MaxOffset = 65535;
+
+		std::uint32_t Read32(const std::uint8_t* Source)
+		{
+			std::uint32_t Value;
+			std::memcpy(&Value, Source, sizeof(Value));
+			return Value;
+		}
+
+		std::uint32_t Hash(std::uint32_t Sequence)
+		{
+			return (Sequence * 2654435761u) >> (32 - HashBits);
+		}
+
+		std::uint8_t* WriteLength(std::uint8_t* Dest, std::size_t Length)
+		{
+			while (Length >= 255)
+			{
+				*Dest++ = 255;
+				Length -= 255;
+			}
+			*Dest++ = static_cast<std::uint8_t>(Length);
+			return Dest;
+		}
+
+		// false if the extension runs past End.
+		bool ReadLength(const std::uint8_t*& Source, const std::uint8_t* End, std::size_t& Length)
+		{
+			std::uint8_t Byte;
+			do
+			{
+				if (Source >= End)
+					return false;
+
+				Byte = *Source++;
+				Length += Byte;
+			}
+			while (Byte == 255);
+			return true;
+		}
+
+		std::uint8_t* WriteSequence(std::uint8_t* Dest, const std::uint8_t* Literals, std::size_t LiteralLength, std::size_t MatchLength)
+		{
+			std::uint8_t* Token = Dest++;
+			*Token = static_cast<std::uint8_t>((LiteralLength < 15 ? LiteralLength : 15) << 4);
+			if (LiteralLength >= 15)
+				Dest = WriteLength(Dest, LiteralLength - 15);
+
+			std::memcpy(Dest, Literals, LiteralLength);
+			Dest += LiteralLength;
+
+			if (MatchLength > 0)
+			{
+				std::size_t Extra = MatchLength - MinMatch;
+				*Token |= static_cast<std::uint8_t>(Extra < 15 ? Extra : 15);
+			}
+			return Dest;
+		}
+	}
+
+	std::size_t LZCompress(const char* Source, std::size_t SourceSize, char* Dest)
+	{
+		auto Begin = reinterpret_cast<const std::uint8_t*>(Source);
+		auto End = Begin + SourceSize;
+		auto Out = reinterpret_cast<std::uint8_t*>(Dest);
+		auto Anchor = Begin;
+
+		if (SourceSize > MatchFindLimit)
+		{
+			std::uint32_t Table[1 << HashBits] = {};
+
+			const std::uint8_t* MatchLimit = End - LastLiterals;
+			const std::uint8_t* FindLimit = End - MatchFindLimit;
+			const std::uint8_t* Current = Begin + 1;
+			std::uint32_t Misses = 0;
+
+			while (Current < FindLimit)
+			{
+				std::uint32_t Sequence = Read32(Current);
+				std::uint32_t& Slot = Table[Hash(Sequence)];
+				const std::uint8_t* Candidate = Begin + Slot;
+				Slot = static_cast<std::uint32_t>(Current - Begin);
+
+				if (Candidate >= Current || static_cast<std::size_t>(Current - Candidate) > MaxOffset || Read32(Candidate) != Sequence)
+				{
+					// skip faster through data that does not compress
+					Current += 1 + (Misses++ >> 6);
+					continue;
+				}
+
+				Misses = 0;
+
+				const std::uint8_t* MatchEnd = Current + MinMatch;
+				const std::uint8_t* Reference = Candidate + MinMatch;
+				while (MatchEnd < MatchLimit && *MatchEnd == *Reference)
+				{
+					++MatchEnd;
+					++Reference;
+				}
+
+				std::size_t MatchLength = static_cast<std::size_t>(MatchEnd - Current);
+				Out = WriteSequence(Out, Anchor, static_cast<std::size_t>(Current - Anchor), MatchLength);
+
+				std::size_t Offset = static_cast<std::size_t>(Current - Candidate);
+				*Out++ = static_cast<std::uint8_t>(Offset);
+				*Out++ = static_cast<std::uint8_t>(Offset >> 8);
+
+				if (MatchLength - MinMatch >= 15)
+					Out = WriteLength(Out, MatchLength - MinMatch - 15);
+
+				Current = MatchEnd;
+				Anchor = Current;
+
+				if (Current - 2 > Begin && Current < FindLimit)
+					Table[Hash(Read32(Current - 2))] = static_cast<std::uint32_t>(Current - 2 - Begin);
+			}
+		}
+
+		Out = WriteSequence(Out, Anchor, static_cast<std::size_t>(End - Anchor), 0);
+		return static_cast<std::size_t>(Out - reinterpret_cast<std::uint8_t*>(Dest));
+	}
+
+	std::ptrdiff_t LZDecompress(const char* Source, std::size_t SourceSize, char* Dest, std::size_t DestCapacity)
+	{
+		auto In = reinterpret_cast<const std::uint8_t*>(Source);
+		auto InEnd = In + SourceSize;
+		auto Begin = reinterpret_cast<std::uint8_t*>(Dest);
+		auto Out = Begin;
+		auto OutEnd = Begin + DestCapacity;
+
+		while (true)
+		{
+			if (In >= InEnd)
+				return -1;
+
+			std::uint8_t Token = *In++;
+
+			std::size_t LiteralLength = Token >> 4;
+			if (LiteralLength == 15 && !ReadLength(In, InEnd, LiteralLength))
+				return -1;
+
+			if (LiteralLength > static_cast<std::size_t>(InEnd - In) || LiteralLength > static_cast<std::size_t>(OutEnd - Out))
+				return -1;
+
+			std::memcpy(Out, In, LiteralLength);
+			Out += LiteralLength;
+			In += LiteralLength;
+
+			// the last sequence has literals only
+			if (In == InEnd)
+				break;
+
+			if (InEnd - In < 2)
+				return -1;
+
+			std::size_t Offset = In[0] | (static_cast<std::size_t>(In[1]) << 8);
+			In += 2;
+
+			if (Offset == 0 || Offset > static_cast<std::size_t>(Out - Begin))
+				return -1;
+
+			std::size_t MatchLength = Token & 15;
+			if (MatchLength == 15 && !ReadLength(In, InEnd, MatchLength))
+				return -1;
+
+			MatchLength += MinMatch;
+			if (MatchLength > static_cast<std::size_t>(OutEnd - Out))
+				return -1;
+
+			const std::uint8_t* Match = Out - Offset;
+			if (Offset >= MatchLength)
+			{
+				std::memcpy(Out, Match, MatchLength);
+				Out += MatchLength;
+			}
+			else
+			{
+				// overlapping matches repeat the last Offset bytes
+				for (std::size_t i = 0; i < MatchLength; ++i)
+				{
+					*Out++ = Match[i];
+				}
+			}
+		}
+
+		return Out - Begin;
+	}
+}
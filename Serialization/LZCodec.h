@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+
+namespace TK
+{
+	// a small LZ77 block codec in the LZ4 block format family, tuned for speed over ratio.
+	// blocks are independent, the decoder validates every length and offset so malformed input
+	// fails instead of reading or writing out of bounds.
+
+	constexpr std::size_t LZCompressBound(std::size_t SourceSize)
+	{
+		return SourceSize + SourceSize / 255 + 16;
+	}
+
+	// the most a block can grow when decompressed, for sizing checks against untrusted input.
+	constexpr std::size_t LZMaxExpansion = 255;
+
+	// Dest must hold LZCompressBound(SourceSize) bytes. returns the compressed size.
+	std::size_t LZCompress(const char* Source, std::size_t SourceSize, char* Dest);
+
+	// returns the decompressed size, or -1 if the input is malformed or does not fit DestCapacity.
+	std::ptrdiff_t LZDecompress(const char* Source, std::size_t SourceSize, char* Dest, std::size_t DestCapacity);
+}
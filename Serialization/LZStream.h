@@ -0,0 +1,177 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "Serialization/OutStream.h"
+#include "Serialization/InStream.h"
+#include "Serialization/LZCodec.h"
+
+namespace TK
+{
+	// raw bytes per compressed block, also the largest block a reader accepts.
+	constexpr std::uint32_t LZBlockSize = 64 * 1024;
+
+	// compresses everything pushed through it block by block into Inner, any out stream works.
+	// each block is a uint32 raw size, a uint32 stored size and the stored bytes, blocks that do
+	// not shrink are stored raw. call Flush() before using what Inner holds.
+	//
+	//     TK::TMemWriter<0> Buffer;
+	//     TK::TLZWriter<TK::TMemWriter<0>> Writer(Buffer);
+	//     Writer & Snapshot;
+	//     Writer.Flush();
+	template<typename InnerType>
+	class TLZWriter : public TOutStream<TLZWriter<InnerType>>
+	{
+		friend class TOutStream<TLZWriter>;
+
+	public:
+
+		using SizeType = FOutStream::SizeType;
+
+		explicit TLZWriter(InnerType& InInner) : Inner(InInner)
+		{
+			Pending.reserve(LZBlockSize);
+		}
+
+		void Flush()
+		{
+			if (!Pending.empty() && this->bValidOutput)
+				this->bValidOutput = WriteBlock();
+		}
+
+		std::uint64_t GetRawBytes() const { return RawBytes; }
+
+		// bytes handed to Inner so far, block headers included.
+		std::uint64_t GetStoredBytes() const { return StoredBytes; }
+
+	protected:
+
+		bool PushBytes(const void* Source, SizeType Length)
+		{
+			auto Bytes = static_cast<const char*>(Source);
+			while (Length > 0)
+			{
+				std::size_t Room = LZBlockSize - Pending.size();
+				std::size_t Chunk = static_cast<std::uint64_t>(Length) < Room ? static_cast<std::size_t>(Length) : Room;
+				Pending.insert(Pending.end(), Bytes, Bytes + Chunk);
+
+				Bytes += Chunk;
+				Length -= static_cast<SizeType>(Chunk);
+
+				if (Pending.size() == LZBlockSize && !WriteBlock())
+					return false;
+			}
+			return true;
+		}
+
+		bool WriteBlock()
+		{
+			Compressed.resize(LZCompressBound(Pending.size()));
+			std::size_t CompressedSize = LZCompress(Pending.data(), Pending.size(), Compressed.data());
+
+			bool bStoreRaw = CompressedSize >= Pending.size();
+			const char* Stored = bStoreRaw ? Pending.data() : Compressed.data();
+			std::uint32_t Header[2] = { static_cast<std::uint32_t>(Pending.size()),
+				static_cast<std::uint32_t>(bStoreRaw ? Pending.size() : CompressedSize) };
+
+			Inner.Push(Header, sizeof(Header));
+			Inner.Push(Stored, Header[1]);
+
+			RawBytes += Header[0];
+			StoredBytes += sizeof(Header) + Header[1];
+			Pending.clear();
+			return Inner.IsValidOutput();
+		}
+
+		InnerType& Inner;
+		std::vector<char> Pending;
+		std::vector<char> Compressed;
+		std::uint64_t RawBytes {0};
+		std::uint64_t StoredBytes {0};
+	};
+
+	// decompresses what TLZWriter produced, pulling blocks from Inner on demand.
+	template<typename InnerType>
+	class TLZReader : public TInStream<TLZReader<InnerType>>
+	{
+		friend class TInStream<TLZReader>;
+
+	public:
+
+		using SizeType = FInStream::SizeType;
+
+		explicit TLZReader(InnerType& InInner) : Inner(InInner) {}
+
+		// the raw size left is unknown until blocks are decoded, so this bounds it by what the
+		// remaining input could expand to.
+		virtual bool EnsureEnoughBytes(SizeType BytesNum) const override
+		{
+			if (BytesNum < 0)
+				return false;
+
+			SizeType Available = static_cast<SizeType>(Block.size() - Offset);
+			if (BytesNum <= Available)
+				return true;
+
+			SizeType Needed = (BytesNum - Available + LZMaxExpansion - 1) / LZMaxExpansion;
+			return Inner.EnsureEnoughBytes(Needed);
+		}
+
+	protected:
+
+		bool PopBytes(void* Dest, SizeType Length)
+		{
+			if (Length < 0)
+				return false;
+
+			auto Bytes = static_cast<char*>(Dest);
+			while (Length > 0)
+			{
+				if (Offset == Block.size() && !ReadBlock())
+					return false;
+
+				std::size_t Available = Block.size() - Offset;
+				std::size_t Chunk = static_cast<std::uint64_t>(Length) < Available ? static_cast<std::size_t>(Length) : Available;
+				std::memcpy(Bytes, Block.data() + Offset, Chunk);
+
+				Offset += Chunk;
+				Bytes += Chunk;
+				Length -= static_cast<SizeType>(Chunk);
+			}
+			return true;
+		}
+
+		bool ReadBlock()
+		{
+			std::uint32_t Header[2] = {};
+			Inner.Pop(Header, sizeof(Header));
+
+			const std::uint32_t RawSize = Header[0];
+			const std::uint32_t StoredSize = Header[1];
+
+			if (!Inner.IsValidInput() || RawSize == 0 || RawSize > LZBlockSize ||
+				StoredSize > LZCompressBound(RawSize) || !Inner.EnsureEnoughBytes(StoredSize))
+				return false;
+
+			Block.resize(RawSize);
+			Offset = 0;
+
+			if (StoredSize == RawSize)
+			{
+				Inner.Pop(Block.data(), RawSize);
+				return Inner.IsValidInput();
+			}
+
+			Compressed.resize(StoredSize);
+			Inner.Pop(Compressed.data(), StoredSize);
+
+			return Inner.IsValidInput() &&
+				LZDecompress(Compressed.data(), StoredSize, Block.data(), RawSize) == static_cast<std::ptrdiff_t>(RawSize);
+		}
+
+		InnerType& Inner;
+		std::vector<char> Block;
+		std::vector<char> Compressed;
+		std::size_t Offset {0};
+	};
+}
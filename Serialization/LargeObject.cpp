@@ -3,7 +3,7 @@
 
 namespace TK
 {
-	void SendBulk(uint16_t MessageId, const char* Data, int Size, const FSender& Sender)
+	void SendBulk(uint16_t MessageId, const char* Data, int Size, const FSender& Sender, bool bChecksum)
 	{
 		FMessage Message(MessageId);
 
@@ -16,7 +16,11 @@ namespace TK
 			if (BytesSent == 0)
 				Status |= PacketFlag::Begin;
 
-			const int AvailableSpace = Message.GetAvailableSpace() - static_cast<int>(sizeof(Status));
+			if (bChecksum)
+				Status |= PacketFlag::Checksum;
+
+			const int FooterSize = bChecksum ? FMessage::GetChecksumSize() : 0;
+			const int AvailableSpace = Message.GetAvailableSpace() - static_cast<int>(sizeof(Status)) - FooterSize;
 			if (AvailableSpace <= 0)
 			{
 				TK_ASSERT(false);
@@ -35,6 +39,9 @@ namespace TK
 			const int Transferred = std::min(RemainedBytes, AvailableSpace);
 			Message.Push(Data + BytesSent, Transferred);
 
+			if (bChecksum)
+				Message.AppendChecksum();
+
 			BytesSent += Transferred;
 			Sender(Message);
 		}
@@ -42,6 +49,19 @@ namespace TK
 
 	void FBulkReceiver::Receive(FMemReader Reader)
 	{
+		if (Reader.GetUnreadBytes() <= 0)
+			return;
+
+		// the policy is ours, not the wire's: a flipped flag must not skip the check. the checksum
+		// covers the status byte too, so it is checked before anything is consumed
+		const bool bFlagged = (*static_cast<const uint8_t*>(Reader.GetReadPos()) & PacketFlag::Checksum) != 0;
+		if (bFlagged != bRequireChecksum || (bRequireChecksum && !StripChecksum(Reader)))
+		{
+			Writer.Clear();
+			State = EState::Corrupted;
+			return;
+		}
+
 		uint8_t Status = Reader.Pop<uint8_t>();
 
 		if (!Reader.IsValidInput())
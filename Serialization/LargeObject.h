@@ -10,11 +10,14 @@ namespace TK
 	{
 		constexpr uint8_t Begin = 0x1;
 		constexpr uint8_t End = 0x2;
+		constexpr uint8_t Checksum = 0x4;
 	}
 
-	using FSender = std::function<void(FMessage&)>;
+	// takes FMessageBase& so one sender serves FMessage, TMessageFor<...> and SendBulk chunks alike.
+	using FSender = std::function<void(FMessageBase&)>;
 
-	void SendBulk(uint16_t MessageId, const char* Data, int Size, const FSender& Sender);
+	// with bChecksum every chunk carries a CRC32C footer that FBulkReceiver verifies.
+	void SendBulk(uint16_t MessageId, const char* Data, int Size, const FSender& Sender, bool bChecksum = false);
 
 	class FBulkReceiver
 	{
@@ -27,8 +30,19 @@ namespace TK
 			Nothing,
 			Inprogress,
 			Completed,
+			Corrupted,
 		};
 
+		FBulkReceiver() = default;
+
+		// the sender's bChecksum, chunks flagged otherwise are treated as corrupted since the
+		// status byte carrying the flag is not covered when no checksum is expected.
+		explicit FBulkReceiver(bool bInRequireChecksum) : bRequireChecksum(bInRequireChecksum) {}
+
+		void SetRequireChecksum(bool bRequire) { bRequireChecksum = bRequire; }
+
+		bool IsChecksumRequired() const { return bRequireChecksum; }
+
 		void SetCompletionHandler(FHandler Handler) { CompletionHandler = std::move(Handler); }
 
 		EState GetState() const { return State; }
@@ -40,6 +54,7 @@ namespace TK
 	private:
 
 		EState State { EState::Nothing };
+		bool bRequireChecksum { false };
 		FHandler CompletionHandler;
 		TMemWriter<0> Writer;
 	};
@@ -0,0 +1,194 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "Serialization/LengthSlot.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/SerializeFuncs.h"
+
+namespace TK
+{
+	// a field decoded on first access. it is saved with a size prefix, loading only records the
+	// bytes, pointing into an FMemReader's buffer or copied from other streams. saving an object
+	// that was never changed writes the recorded bytes back verbatim, so relays forward it
+	// without a decode and encode round trip. the first Get() on a shared object is not thread safe.
+	//
+	// bytes loaded from an FMemReader stay in its buffer, which has to outlive this TLazy, even
+	// decoded, until GetMutable() drops them. copies own their bytes, and Detach() makes this one
+	// own them before the buffer goes away.
+	//
+	//     struct FEnvelope
+	//     {
+	//         int Route;
+	//         TK::TLazy<FPayload> Payload;
+	//         TK_SERIAL(Route, Payload)
+	//     };
+	template<typename T>
+	class TLazy
+	{
+	public:
+
+		TLazy() = default;
+
+		explicit TLazy(T InValue) : Value(std::move(InValue)) {}
+
+		TLazy(const TLazy& Other) : Value(Other.Value), bDecoded(Other.bDecoded), bValid(Other.bValid),
+			bEncoded(Other.bEncoded), External(Other.External), Owned(Other.Owned), EncodedSize(Other.EncodedSize),
+			Encoding(Other.Encoding)
+		{
+			Detach();
+		}
+
+		TLazy(TLazy&&) = default;
+
+		TLazy& operator=(const TLazy& Other)
+		{
+			if (this != &Other)
+				*this = TLazy(Other);
+			return *this;
+		}
+
+		TLazy& operator=(TLazy&&) = default;
+
+		TLazy& operator=(T InValue)
+		{
+			Value = std::move(InValue);
+			bDecoded = true;
+			bValid = true;
+			DropEncoded();
+			return *this;
+		}
+
+		// decodes on first call, a default T when the bytes are malformed.
+		const T& Get() const
+		{
+			Decode();
+			return Value;
+		}
+
+		// the recorded bytes are dropped, saving encodes the value again.
+		T& GetMutable()
+		{
+			Decode();
+			DropEncoded();
+			return Value;
+		}
+
+		bool IsDecoded() const { return bDecoded; }
+
+		// decodes if needed and tells whether the bytes made a whole T.
+		bool IsValid() const { return Decode(); }
+
+		bool HasEncoded() const { return bEncoded; }
+
+		std::uint32_t GetEncodedSize() const { return EncodedSize; }
+
+		const char* GetEncodedData() const { return External ? External : Owned.data(); }
+
+		// copies bytes still pointing into a reader's buffer, which may then go away.
+		void Detach()
+		{
+			if (External)
+			{
+				Owned.assign(External, External + EncodedSize);
+				External = nullptr;
+			}
+		}
+
+		bool IsDetached() const { return External == nullptr; }
+
+		template<typename StreamType>
+		void Save(StreamType& Stream) const
+		{
+			static_assert(!IsBitStream<StreamType>, "lazy fields need a byte stream.");
+
+			if (bEncoded && Encoding == Stream.GetIntEncoding())
+			{
+				SaveSize(Stream, EncodedSize);
+				Stream.Push(GetEncodedData(), EncodedSize);
+				return;
+			}
+
+			if (!Decode())
+			{
+				Stream.MarkOutputInvalid();
+				return;
+			}
+
+			SaveSizePrefixed(Stream, Value, GetSizeSlot(Stream));
+		}
+
+		template<typename StreamType>
+		void Load(StreamType& Stream)
+		{
+			static_assert(!IsBitStream<StreamType>, "lazy fields need a byte stream.");
+
+			if (!Stream.IsValidInput())
+				return;
+
+			std::uint32_t Length = LoadSize(Stream);
+			if (!Stream.EnsureEnoughBytes(Length))
+			{
+				Stream.MarkInputInvalid();
+				return;
+			}
+
+			Value = T();
+			bDecoded = false;
+			bValid = true;
+			bEncoded = true;
+			EncodedSize = Length;
+			Encoding = Stream.GetIntEncoding();
+
+			if constexpr (IsMemReader<StreamType>)
+			{
+				External = static_cast<const char*>(Stream.GetReadPos());
+				Owned.clear();
+				Stream.Advance(Length);
+			}
+			else
+			{
+				External = nullptr;
+				Owned.resize(Length);
+				Stream.Pop(Owned.data(), Length);
+			}
+		}
+
+	private:
+
+		bool Decode() const
+		{
+			if (!bDecoded)
+			{
+				bDecoded = true;
+
+				FMemReader Reader(GetEncodedData(), EncodedSize);
+				Reader.SetIntEncoding(Encoding);
+				Reader & Value;
+
+				bValid = Reader.IsValidInput() && Reader.GetUnreadBytes() == 0;
+				if (!bValid)
+					Value = T();
+			}
+			return bValid;
+		}
+
+		void DropEncoded()
+		{
+			bEncoded = false;
+			External = nullptr;
+			EncodedSize = 0;
+			Owned = std::vector<char>();
+		}
+
+		mutable T Value {};
+		mutable bool bDecoded {true};
+		mutable bool bValid {true};
+
+		bool bEncoded {false};
+		const char* External {nullptr};
+		std::vector<char> Owned;
+		std::uint32_t EncodedSize {0};
+		EIntEncoding Encoding {EIntEncoding::Fixed};
+	};
+}
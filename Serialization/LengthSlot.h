@@ -0,0 +1,161 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/SerializeFuncs.h"
+#include "Serialization/SizeCounter.h"
+
+namespace TK
+{
+	// writers that can rewrite the bytes they hold, like TMemWriter, FSpanWriter and
+	// TSegmentedWriter. a length prefix is reserved on them, the value written right after it, and
+	// the length filled in last. FSizeCounter takes part by counting the prefix it would fill in.
+	template<typename StreamType, typename = void>
+	inline constexpr bool CanBackfill = false;
+
+	template<typename StreamType>
+	inline constexpr bool CanBackfill<StreamType, std::void_t<decltype(std::declval<StreamType&>().Overwrite(
+		std::size_t(), std::declval<const void*>(), std::size_t()))>> = true;
+
+	// backfilling writers that can also drop the unused part of a varint slot, by moving what
+	// follows it down through GetBuffer() and ShrinkTo(). a size counter only shrinks.
+	template<typename StreamType, typename = void>
+	inline constexpr bool CanCompactSlot = false;
+
+	template<typename StreamType>
+	inline constexpr bool CanCompactSlot<StreamType, std::void_t<decltype(std::declval<StreamType&>().ShrinkTo(std::size_t()))>> =
+		CanBackfill<StreamType>;
+
+	template<typename StreamType, typename = void>
+	inline constexpr bool HasSlotBuffer = false;
+
+	template<typename StreamType>
+	inline constexpr bool HasSlotBuffer<StreamType, std::enable_if_t<std::is_same_v<decltype(std::declval<StreamType&>().GetBuffer()), char*>>> = true;
+
+	// bytes before GetPinnedSize() were handed out by pointer and must not move.
+	template<typename StreamType, typename = void>
+	inline constexpr bool HasPinnedBytes = false;
+
+	template<typename StreamType>
+	inline constexpr bool HasPinnedBytes<StreamType, std::void_t<decltype(std::declval<const StreamType&>().GetPinnedSize())>> = true;
+
+	enum class ELengthSlot : std::uint8_t
+	{
+		Fixed32,
+		Varint,
+	};
+
+	constexpr std::size_t LengthSlotWidth(ELengthSlot Kind)
+	{
+		return Kind == ELengthSlot::Fixed32 ? sizeof(std::uint32_t) : static_cast<std::size_t>(MaxVarintBytes<std::uint32_t>);
+	}
+
+	// the slot SaveSize would write on Stream.
+	template<typename StreamType>
+	ELengthSlot GetSizeSlot(const StreamType& Stream)
+	{
+		return Stream.GetIntEncoding() == EIntEncoding::Varint ? ELengthSlot::Varint : ELengthSlot::Fixed32;
+	}
+
+	struct FLengthSlot
+	{
+		std::size_t Offset {0};
+		ELengthSlot Kind {ELengthSlot::Fixed32};
+	};
+
+	// reserves the widest length of Kind, everything pushed until EndLengthSlot is what it measures.
+	template<typename StreamType>
+	FLengthSlot BeginLengthSlot(StreamType& Stream, ELengthSlot Kind)
+	{
+		static_assert(CanBackfill<StreamType>, "length slots need a writer that can backfill.");
+
+		FLengthSlot Slot { Stream.GetSize(), Kind };
+		const char Zeros[LengthSlotWidth(ELengthSlot::Varint)] {};
+		Stream.Push(Zeros, LengthSlotWidth(Kind));
+		return Slot;
+	}
+
+	// fills in the slot. a varint shorter than the slot moves the measured bytes down over the
+	// unused part, so the bytes are the same as a prefix written up front. writers that cannot
+	// move them, TSegmentedWriter and an FSpanWriter with reserved bytes inside the slot, keep the
+	// slot's width and pad the varint with continuation bits instead, which every reader decodes.
+	template<typename StreamType>
+	void EndLengthSlot(StreamType& Stream, const FLengthSlot& Slot)
+	{
+		if (!Stream.IsValidOutput())
+			return;
+
+		const std::size_t Size = Stream.GetSize();
+		const std::size_t Width = LengthSlotWidth(Slot.Kind);
+		const std::size_t Length = Size - Slot.Offset - Width;
+		if (IsSizeOverflow(Length))
+		{
+			Stream.MarkOutputInvalid();
+			TK_ASSERT(false);
+			return;
+		}
+
+		if (Slot.Kind == ELengthSlot::Fixed32)
+		{
+			auto Value = static_cast<std::uint32_t>(Length);
+			Stream.Overwrite(Slot.Offset, &Value, sizeof(Value));
+			return;
+		}
+
+		std::uint8_t Buffer[LengthSlotWidth(ELengthSlot::Varint)];
+		auto Bytes = static_cast<std::size_t>(GetVarintSize(Length));
+
+		bool bCompact = CanCompactSlot<StreamType> && Bytes < Width;
+		if constexpr (HasPinnedBytes<StreamType>)
+			bCompact = bCompact && Stream.GetPinnedSize() <= Slot.Offset;
+
+		if (!bCompact)
+		{
+			EncodeVarintPadded(Length, Buffer, static_cast<int>(Width));
+			Stream.Overwrite(Slot.Offset, Buffer, Width);
+			return;
+		}
+
+		if constexpr (CanCompactSlot<StreamType>)
+		{
+			EncodeVarint(Length, Buffer);
+			Stream.Overwrite(Slot.Offset, Buffer, Bytes);
+
+			if constexpr (HasSlotBuffer<StreamType>)
+			{
+				char* Child = Stream.GetBuffer() + Slot.Offset;
+				std::memmove(Child + Bytes, Child + Width, Length);
+			}
+			Stream.ShrinkTo(Size - (Width - Bytes));
+		}
+	}
+
+	// Value behind its encoded size, in one pass on writers that can backfill. the others,
+	// FFileWriter, TLZWriter and TCrcWriter, cannot rewrite what they already passed on, so the
+	// outermost value goes through a scratch TMemWriter, nested ones backfill inside it.
+	template<typename StreamType, typename T>
+	void SaveSizePrefixed(StreamType& Stream, const T& Value, ELengthSlot Kind)
+	{
+		if constexpr (CanBackfill<StreamType>)
+		{
+			FLengthSlot Slot = BeginLengthSlot(Stream, Kind);
+			Stream & Value;
+			EndLengthSlot(Stream, Slot);
+		}
+		else
+		{
+			TMemWriter<256> Scratch;
+			Scratch.SetIntEncoding(Stream.GetIntEncoding());
+			SaveSizePrefixed(Scratch, Value, Kind);
+			if (!Scratch.IsValidOutput())
+			{
+				Stream.MarkOutputInvalid();
+				return;
+			}
+
+			Stream.Push(Scratch.GetBuffer(), Scratch.GetSize());
+		}
+	}
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <cstdint>
+#include "Serialization/InStream.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/SerializeFuncs.h"
+
+namespace TK
+{
+	// pops at most Limit bytes from Inner, keeps a length prefixed value from reading past its
+	// end on streams that cannot be sliced like FMemReader.
+	template<typename InnerType>
+	class TLimitedReader : public TInStream<TLimitedReader<InnerType>>
+	{
+		friend class TInStream<TLimitedReader>;
+
+	public:
+
+		using SizeType = FInStream::SizeType;
+
+		TLimitedReader(InnerType& InInner, SizeType InLimit) : Inner(InInner), Remained(InLimit)
+		{
+			this->IntEncoding = Inner.GetIntEncoding();
+			this->bReuseContainers = Inner.IsReusingContainers();
+		}
+
+		SizeType GetUnreadBytes() const { return Remained; }
+
+		virtual bool EnsureEnoughBytes(SizeType BytesNum) const override
+		{
+			return BytesNum >= 0 && BytesNum <= Remained && Inner.EnsureEnoughBytes(BytesNum);
+		}
+
+	protected:
+
+		bool PopBytes(void* Dest, SizeType Length)
+		{
+			if (Length < 0 || Length > Remained)
+				return false;
+
+			Inner.Pop(Dest, Length);
+			Remained -= Length;
+			return Inner.IsValidInput();
+		}
+
+		InnerType& Inner;
+		SizeType Remained;
+	};
+
+	template<typename StreamType>
+	void SkipBytes(StreamType& Stream, std::uint32_t Length)
+	{
+		if (!Stream.EnsureEnoughBytes(Length))
+		{
+			Stream.MarkInputInvalid();
+			return;
+		}
+
+		if constexpr (IsMemReader<StreamType>)
+		{
+			Stream.Advance(Length);
+		}
+		else
+		{
+			char Scratch[256];
+			while (Length > 0 && Stream.IsValidInput())
+			{
+				std::uint32_t Chunk = Length < sizeof(Scratch) ? Length : static_cast<std::uint32_t>(sizeof(Scratch));
+				Stream.Pop(Scratch, Chunk);
+				Length -= Chunk;
+			}
+		}
+	}
+
+	// decodes Data from exactly the next Length bytes, the input turns invalid if it reads less
+	// or would read more. FMemReader slices in place so views still point into its buffer.
+	template<typename StreamType, typename T>
+	void LoadBounded(StreamType& Stream, T& Data, std::uint32_t Length)
+	{
+		if (!Stream.IsValidInput())
+			return;
+
+		if constexpr (IsMemReader<StreamType>)
+		{
+			if (!Stream.EnsureEnoughBytes(Length))
+			{
+				Stream.MarkInputInvalid();
+				return;
+			}
+
+			FMemReader Slice(Stream.GetReadPos(), Length);
+			Slice.SetIntEncoding(Stream.GetIntEncoding());
+			Slice.SetReuseContainers(Stream.IsReusingContainers());
+			Slice & Data;
+
+			if (Slice.IsValidInput() && Slice.GetUnreadBytes() == 0)
+			{
+				Stream.Advance(Length);
+			}
+			else
+			{
+				Stream.MarkInputInvalid();
+			}
+		}
+		else
+		{
+			TLimitedReader<StreamType> Slice(Stream, Length);
+			Slice & Data;
+
+			if (!Slice.IsValidInput() || Slice.GetUnreadBytes() != 0)
+				Stream.MarkInputInvalid();
+		}
+	}
+}
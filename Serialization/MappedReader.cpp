@@ -0,0 +1,139 @@
+#include "MappedReader.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace TK
+{
+	FMappedReader::~FMappedReader()
+	{
+		Close();
+	}
+
+#ifdef _WIN32
+	bool FMappedReader::Open(const char* Path, bool /*bHugePages*/)
+	{
+		Close();
+
+		HANDLE File = CreateFileA(Path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (File == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER FileSize;
+		if (!GetFileSizeEx(File, &FileSize))
+		{
+			CloseHandle(File);
+			return false;
+		}
+
+		if (FileSize.QuadPart > 0)
+		{
+			MappingHandle = CreateFileMappingA(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			Mapped = MappingHandle ? MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+			if (!Mapped)
+			{
+				if (MappingHandle)
+					CloseHandle(MappingHandle);
+
+				MappingHandle = nullptr;
+				CloseHandle(File);
+				return false;
+			}
+		}
+
+		// the mapping keeps the file alive on its own
+		CloseHandle(File);
+
+		MappedSize = static_cast<std::size_t>(FileSize.QuadPart);
+		bOpened = true;
+		Init(Mapped, MappedSize);
+		return true;
+	}
+
+	void FMappedReader::Close()
+	{
+		if (Mapped)
+			UnmapViewOfFile(Mapped);
+
+		if (MappingHandle)
+			CloseHandle(MappingHandle);
+
+		Mapped = nullptr;
+		MappingHandle = nullptr;
+		MappedSize = 0;
+		bOpened = false;
+
+		Init(nullptr, 0);
+		bValidInput = false;
+	}
+#else
+	bool FMappedReader::Open(const char* Path, bool bHugePages)
+	{
+		Close();
+
+		int Handle = open(Path, O_RDONLY);
+		if (Handle < 0)
+			return false;
+
+		struct stat Stat;
+		if (fstat(Handle, &Stat) != 0)
+		{
+			close(Handle);
+			return false;
+		}
+
+		std::size_t FileSize = static_cast<std::size_t>(Stat.st_size);
+		if (FileSize > 0)
+		{
+			void* Address = mmap(nullptr, FileSize, PROT_READ, MAP_PRIVATE, Handle, 0);
+			if (Address == MAP_FAILED)
+			{
+				close(Handle);
+				return false;
+			}
+
+			Mapped = Address;
+
+			// hints only, a kernel that ignores them still maps the file correctly
+			madvise(Mapped, FileSize, MADV_SEQUENTIAL);
+			madvise(Mapped, FileSize, MADV_WILLNEED);
+
+#if defined(MADV_HUGEPAGE)
+			if (bHugePages)
+				madvise(Mapped, FileSize, MADV_HUGEPAGE);
+#endif
+		}
+
+		// the mapping keeps the file alive on its own
+		close(Handle);
+
+		MappedSize = FileSize;
+		bOpened = true;
+		Init(Mapped, MappedSize);
+		return true;
+	}
+
+	void FMappedReader::Close()
+	{
+		if (Mapped)
+			munmap(Mapped, MappedSize);
+
+		Mapped = nullptr;
+		MappedSize = 0;
+		bOpened = false;
+
+		Init(nullptr, 0);
+		bValidInput = false;
+	}
+#endif
+}
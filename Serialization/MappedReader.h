@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include "Serialization/MemoryReader.h"
+
+namespace TK
+{
+	// FMemReader over a read only mapping of a whole file. pages are faulted in as the reader
+	// advances instead of the file being read up front, and GetReadPos() based loads such as
+	// string_view and TArrayView point straight into the mapping. the mapping is advised for
+	// sequential access, bHugePages additionally asks for transparent huge pages on Linux.
+	// FMemReader copies and views stay valid until Close() or destruction.
+	class FMappedReader : public FMemReader
+	{
+	public:
+
+		FMappedReader() { bValidInput = false; }
+		~FMappedReader() override;
+
+		FMappedReader(const FMappedReader&) = delete;
+		FMappedReader& operator=(const FMappedReader&) = delete;
+
+		bool Open(const char* Path, bool bHugePages = false);
+
+		void Close();
+
+		bool IsOpen() const { return bOpened; }
+
+		std::size_t GetMappedSize() const { return MappedSize; }
+
+	private:
+
+		void* Mapped {nullptr};
+		std::size_t MappedSize {0};
+		bool bOpened {false};
+
+#ifdef _WIN32
+		void* MappingHandle {nullptr};
+#endif
+	};
+}
@@ -1,11 +1,16 @@
 #pragma once
+#include <cstring>
+#include <limits>
 #include "Serialization/InStream.h"
+#include "TinkerAssert.h"
 
 
 namespace TK
 {
-	class FMemReader : public FInStream
+	class FMemReader : public TInStream<FMemReader>
 	{
+		friend class TInStream<FMemReader>;
+		
 	public:
 		
 		FMemReader() = default;
@@ -21,9 +26,12 @@ namespace TK
 		FMemReader& operator=(const FMemReader&) = default;
 		FMemReader& operator=(FMemReader&&) = default;
 
+		// resets the reader onto a new buffer, the integer encoding and reuse mode are kept.
 		void Init(const void* Source, SizeType Length)
 		{
 			FMemReader Tmp(Source, Length);
+			Tmp.IntEncoding = IntEncoding;
+			Tmp.bReuseContainers = bReuseContainers;
 			*this = Tmp;
 		}
 		
@@ -44,10 +52,67 @@ namespace TK
 
 	protected:
 		
-		virtual bool PopImpl(void* Dest, SizeType Length) override;
+		bool PopBytes(void* Dest, SizeType Length)
+		{
+			if (Length > GetUnreadBytes() || Length < 0)
+				return false;
+
+			if constexpr (sizeof(uint64_t) > sizeof(std::size_t))
+			{
+				if (static_cast<uint64_t>(Length) > std::numeric_limits<std::size_t>::max())
+					return false;
+			}
+			
+			std::memcpy(Dest, static_cast<const char*>(Buffer) + Offset, static_cast<std::size_t>(Length));
+			Offset += Length;
+			return true;
+		}
 
 		const void* Buffer {nullptr};
 		SizeType Size {0};
 		SizeType Offset {0};
 	};
+
+	// pops from a block the caller has already validated, used to decode objects whose encoded
+	// size is fixed with a single check up front. see LoadBlock in SerializeFuncs.h.
+	// the integer encoding is always fixed, which also lets the per field encoding branches fold.
+	class FMemBlockReader : public TInStream<FMemBlockReader>
+	{
+		friend class TInStream<FMemBlockReader>;
+
+	public:
+
+		template<typename InSizeType>
+		FMemBlockReader(const void* Source, InSizeType Length) : Cursor(static_cast<const char*>(Source)),
+			End(static_cast<const char*>(Source) + Length) {}
+
+		constexpr EIntEncoding GetIntEncoding() const { return EIntEncoding::Fixed; }
+
+		SizeType GetUnreadBytes() const { return End - Cursor; }
+
+		virtual bool EnsureEnoughBytes(SizeType BytesNum) const override
+		{
+			return BytesNum >= 0 && End - Cursor >= BytesNum;
+		}
+
+	protected:
+
+		// a single compare stays in release builds, so a Load reading more than TFixedSize says
+		// fails instead of running past the block.
+		bool PopBytes(void* Dest, SizeType Length)
+		{
+			if (Length < 0 || End - Cursor < Length)
+			{
+				TK_ASSERT(false);
+				return false;
+			}
+
+			std::memcpy(Dest, Cursor, static_cast<std::size_t>(Length));
+			Cursor += Length;
+			return true;
+		}
+
+		const char* Cursor;
+		const char* End;
+	};
 }
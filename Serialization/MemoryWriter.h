@@ -1,4 +1,7 @@
 #pragma once
+#include <cstring>
+#include <limits>
+#include <memory>
 #include <variant>
 #include <vector>
 #include <array>
@@ -16,25 +19,32 @@ namespace TK
 		int Size {0};
 	};
 	
-	template<int N>
+	template<int N, typename AllocatorType>
 	struct TMemWriterStorage
 	{
-		using Type = std::variant<TInlinedMemory<N>, std::vector<char>>;
+		using Type = std::variant<TInlinedMemory<N>, std::vector<char, AllocatorType>>;
 	};
 
-	template<>
-	struct TMemWriterStorage<0>
+	template<typename AllocatorType>
+	struct TMemWriterStorage<0, AllocatorType>
 	{
-		using Type = std::vector<char>;
+		using Type = std::vector<char, AllocatorType>;
 	};
 
-	template<int N = 64>
-	class TMemWriter : public FOutStream
+	// AllocatorType backs the heap buffer, TPoolAllocator<char> from BufferPool.h recycles it.
+	template<int N = 64, typename AllocatorType = std::allocator<char>>
+	class TMemWriter : public TOutStream<TMemWriter<N, AllocatorType>>
 	{
 		static_assert(N >= 0, "N cannot be negative.");
+
+		friend class TOutStream<TMemWriter>;
 		
 	public:
 
+		using SizeType = FOutStream::SizeType;
+		using HeapType = std::vector<char, AllocatorType>;
+		using StorageType = typename TMemWriterStorage<N, AllocatorType>::Type;
+
 		std::size_t GetSize() const
 		{
 			if constexpr (N == 0)
@@ -85,7 +95,7 @@ namespace TK
 
 		void Clear()
 		{
-			bValidOutput = true;
+			this->bValidOutput = true;
 			
 			if constexpr (N == 0)
 			{
@@ -116,13 +126,13 @@ namespace TK
 				{
 					if (Capacity > N)
 					{
-						std::vector<char> Heap;
+						HeapType Heap;
 						Heap.reserve(Capacity);
 
 						const char* CurrentBuffer = std::get<0>(Storage).Data.data();
 						int CurrentSize = std::get<0>(Storage).Size;
 						
-						Heap.insert(Heap.end(), CurrentBuffer, CurrentBuffer + CurrentSize);
+						Append(Heap, CurrentBuffer, CurrentSize);
 						Storage = std::move(Heap);
 					}
 				}
@@ -158,6 +168,23 @@ namespace TK
 			}
 		}
 		
+		// rewrites Length bytes already written at Offset, used to fill in reserved length prefixes.
+		void Overwrite(std::size_t Offset, const void* Source, std::size_t Length)
+		{
+			TK_ASSERT(Offset <= GetSize() && Length <= GetSize() - Offset);
+			std::memcpy(GetBuffer() + Offset, Source, Length);
+		}
+
+		// moves the written bytes out as they are stored, inline or on the heap, and leaves the
+		// writer empty. TK::Freeze() in SharedBuffer.h builds on it.
+		StorageType TakeStorage()
+		{
+			StorageType Taken = std::move(Storage);
+			Storage = StorageType();
+			Clear();
+			return Taken;
+		}
+		
 	protected:
 
 		bool Inlined() const
@@ -172,12 +199,29 @@ namespace TK
 			}
 		}
 		
-		virtual bool PushImpl(const void* Source, SizeType Length) override
+		// libstdc++ copies element by element into vectors with a custom allocator, so those
+		// grow with resize and memcpy instead of insert.
+		template<typename LengthType>
+		static void Append(HeapType& Heap, const char* Source, LengthType Length)
+		{
+			if constexpr (std::is_same_v<AllocatorType, std::allocator<char>>)
+			{
+				Heap.insert(Heap.end(), Source, Source + Length);
+			}
+			else
+			{
+				std::size_t Offset = Heap.size();
+				Heap.resize(Offset + static_cast<std::size_t>(Length));
+				std::memcpy(Heap.data() + Offset, Source, static_cast<std::size_t>(Length));
+			}
+		}
+
+		bool PushBytes(const void* Source, SizeType Length)
 		{
 			if (Length <= 0)
 				return true;
 
-			using StorageSizeType = std::vector<char>::size_type;
+			using StorageSizeType = typename HeapType::size_type;
 			constexpr uint64_t MaxCapacity = static_cast<uint64_t>(std::numeric_limits<StorageSizeType>::max());
 			
 			bool bOverflow = static_cast<uint64_t>(Length) + GetSize() > MaxCapacity;
@@ -187,11 +231,10 @@ namespace TK
 				return false;
 
 			auto Begin = static_cast<const char*>(Source);
-			auto End = Begin + Length;
 			
 			if constexpr (N == 0)
 			{
-				Storage.insert(Storage.end(), Begin, End);
+				Append(Storage, Begin, Length);
 				return true;
 			}
 			else
@@ -213,10 +256,10 @@ namespace TK
 					}
 					else
 					{
-						std::vector<char> Heap;
+						HeapType Heap;
 						Heap.reserve(static_cast<StorageSizeType>(Required));
-						Heap.insert(Heap.end(), Buffer, Buffer + Current);
-						Heap.insert(Heap.end(), Begin, End);
+						Append(Heap, Buffer, Current);
+						Append(Heap, Begin, Length);
 
 						Storage = std::move(Heap);
 					}
@@ -224,13 +267,42 @@ namespace TK
 				else
 				{
 					auto& Vec = std::get<1>(Storage);
-					Vec.insert(Vec.end(), Begin, End);
+					Append(Vec, Begin, Length);
 				}
 			}
 			return true;
 		}
 
-		typename TMemWriterStorage<N>::Type Storage { };
+		StorageType Storage { };
 	};
 
+	// writes into a caller's buffer known to be large enough, nothing grows and the bounds are
+	// only asserted.
+	class FMemBlockWriter : public TOutStream<FMemBlockWriter>
+	{
+		friend class TOutStream<FMemBlockWriter>;
+
+	public:
+
+		template<typename InSizeType>
+		FMemBlockWriter(void* Dest, InSizeType Length) : Begin(static_cast<char*>(Dest)), Cursor(Begin),
+			End(Begin + Length) {}
+
+		std::size_t GetSize() const { return static_cast<std::size_t>(Cursor - Begin); }
+
+	protected:
+
+		bool PushBytes(const void* Source, SizeType Length)
+		{
+			TK_ASSERT(Length >= 0 && End - Cursor >= Length);
+
+			std::memcpy(Cursor, Source, static_cast<std::size_t>(Length));
+			Cursor += Length;
+			return true;
+		}
+
+		char* Begin;
+		char* Cursor;
+		char* End;
+	};
 }
@@ -1,16 +1,28 @@
 #pragma once
+#include "Serialization/BufferPool.h"
+#include "Serialization/Checksum.h"
 #include "Serialization/MemoryWriter.h"
+#include "Serialization/SharedBuffer.h"
+#include "Serialization/SizeCounter.h"
 #include <limits>
 
 namespace TK
 {
-	class FMessage : public TMemWriter<64>
+	// bytes all of Args take at most, 0 when any of them has no MaxEncodedSize.
+	template<typename ...ArgTypes>
+	inline constexpr std::size_t MaxPackedSize = ((MaxEncodedSize<ArgTypes> > 0) && ...) ?
+		(MaxEncodedSize<ArgTypes> + ... + 0) : 0;
+
+	// what every TMessage<InlineSize> shares, the header layout and the finished bytes. the send
+	// path takes FMessageBase& so messages of any inline size go through it, at the cost of one
+	// virtual call to reach the buffer.
+	class FMessageBase
 	{
 	public:
-		
+
 		using FHeaderSizeType = uint16_t;
 		constexpr static int MaxSize = 30000;
-		
+
 		static_assert(MaxSize <= std::numeric_limits<FHeaderSizeType>::max(),
 			"FMessage::MaxSize is too large.");
 
@@ -22,23 +34,24 @@ namespace TK
 		};
 #pragma pack()
 
-		explicit FMessage(uint16_t Tag)
-		{
-			FHeader Header { 0, Tag };
-			Push(&Header, sizeof(Header));
-		}
+		FMessageBase() = default;
+		virtual ~FMessageBase() = default;
+
+		FMessageBase(const FMessageBase&) = default;
+		FMessageBase(FMessageBase&&) = default;
+
+		FMessageBase& operator=(const FMessageBase&) = default;
+		FMessageBase& operator=(FMessageBase&&) = default;
+
+		virtual char* GetBuffer() = 0;
+
+		virtual const char* GetBuffer() const = 0;
+
+		virtual std::size_t GetSize() const = 0;
 
-		template<typename EnumType>
-		explicit FMessage(EnumType Tag) : FMessage(static_cast<uint16_t>(Tag)) {}
-		
 		constexpr static int GetHeadSize() { return static_cast<int>(sizeof(FHeader)); }
 
-		template<typename ...ArgTypes>
-		void Pack(ArgTypes&&... Args)
-		{
-			using namespace TK;
-			((*this) & ... & std::forward<ArgTypes>(Args));
-		}
+		constexpr static int GetChecksumSize() { return static_cast<int>(sizeof(std::uint32_t)); }
 
 		bool OverFlow() const
 		{
@@ -58,14 +71,113 @@ namespace TK
 			return true;
 		}
 
+		FHeader* GetHeader() { return reinterpret_cast<FHeader*>(GetBuffer()); }
+
+		const FHeader* GetHeader() const { return reinterpret_cast<const FHeader*>(GetBuffer()); }
+	};
+
+	// spilled buffers come from the thread's FBufferPool instead of a fresh allocation each time.
+	// InlineSize is the buffer kept inside the message, FMessage keeps 64 bytes and
+	// TMessageFor<ArgTypes...> exactly what its header and Args can take.
+	template<int InlineSize>
+	class TMessage : public TMemWriter<InlineSize, TPoolAllocator<char>>, public FMessageBase
+	{
+		using Super = TMemWriter<InlineSize, TPoolAllocator<char>>;
+
+	public:
+
+		explicit TMessage(uint16_t Tag)
+		{
+			FHeader Header { 0, Tag };
+			this->Push(&Header, sizeof(Header));
+		}
+
+		template<typename EnumType>
+		explicit TMessage(EnumType Tag) : TMessage(static_cast<uint16_t>(Tag)) {}
+
+		char* GetBuffer() override { return Super::GetBuffer(); }
+
+		const char* GetBuffer() const override { return Super::GetBuffer(); }
+
+		std::size_t GetSize() const override { return Super::GetSize(); }
+
+		template<typename ...ArgTypes>
+		void Pack(ArgTypes&&... Args)
+		{
+			using namespace TK;
+			((*this) & ... & std::forward<ArgTypes>(Args));
+		}
+
+		// Pack for Args with a MaxEncodedSize. when their bound fits in the inline space left,
+		// as it always does right after constructing a TMessageFor<ArgTypes...>, they are written
+		// with no per field capacity checks.
+		template<typename ...ArgTypes>
+		void PackBounded(const ArgTypes&... Args)
+		{
+			constexpr std::size_t Bound = MaxPackedSize<ArgTypes...>;
+			static_assert(Bound > 0, "PackBounded needs types with a MaxEncodedSize.");
+
+			if constexpr (InlineSize > 0)
+			{
+				if (this->Inlined() && this->IsValidOutput() && this->GetSize() + Bound <= static_cast<std::size_t>(InlineSize))
+				{
+					using namespace TK;
+					auto& Inline = std::get<0>(this->Storage);
+					FMemBlockWriter Writer(Inline.Data.data() + Inline.Size, Bound);
+					Writer.SetIntEncoding(this->GetIntEncoding());
+					(Writer & ... & Args);
+
+					Inline.Size += static_cast<int>(Writer.GetSize());
+					return;
+				}
+			}
+			Pack(Args...);
+		}
+
+		// whether Args still fit in the space left, measured in the message's integer encoding
+		// without packing them. callers can switch to SendBulk before serializing anything.
+		template<typename ...ArgTypes>
+		bool CanPack(const ArgTypes&... Args) const
+		{
+			int Space = GetAvailableSpace();
+			if (Space < 0)
+				return false;
+
+			FSizeCounter Counter;
+			Counter.SetIntEncoding(this->GetIntEncoding());
+			(Counter & ... & Args);
+			return Counter.GetSize() <= static_cast<std::size_t>(Space);
+		}
+
+		// appends a CRC32C of everything after the header, call it last and before UpdateHeader().
+		// the receiver checks and drops it with TK::StripChecksum(Reader).
+		void AppendChecksum()
+		{
+			std::uint32_t Crc = Crc32c(this->GetBuffer() + GetHeadSize(), this->GetSize() - GetHeadSize());
+			this->Push(&Crc, sizeof(Crc));
+		}
+
 		void ClearContent()
 		{
-			ShrinkTo(sizeof(FHeaderSizeType));
+			this->ShrinkTo(sizeof(FHeader));
 		}
 
-		FHeader* GetHeader() { return reinterpret_cast<FHeader*>(GetBuffer()); }
-		
-		const FHeader* GetHeader() const { return reinterpret_cast<const FHeader*>(GetBuffer()); }
+		// updates the header and moves the whole message into an FSharedBuffer that any number of
+		// send queues can hold without copying it. the message keeps only its header afterwards,
+		// and the buffer is empty when the message overflowed.
+		FSharedBuffer Freeze()
+		{
+			FHeader Header { 0, GetHeader()->Tag };
+			if (!UpdateHeader())
+			{
+				ClearContent();
+				return FSharedBuffer();
+			}
+
+			FSharedBuffer Buffer = TK::Freeze(*this);
+			this->Push(&Header, sizeof(Header));
+			return Buffer;
+		}
 
 		void SetSizeLimit(int Limit)
 		{
@@ -73,10 +185,32 @@ namespace TK
 				MaxSizeAllowed = Limit;
 		}
 
-		int GetAvailableSpace() const { return MaxSizeAllowed - static_cast<int>(GetSize()); }
+		int GetAvailableSpace() const { return MaxSizeAllowed - static_cast<int>(this->GetSize()); }
 
 	private:
 
 		int MaxSizeAllowed { MaxSize };	
 	};
-}
\ No newline at end of file
+
+	using FMessage = TMessage<64>;
+
+	template<typename ...ArgTypes>
+	constexpr int MessageSizeFor()
+	{
+		constexpr std::size_t Bound = MaxPackedSize<ArgTypes...>;
+		static_assert(Bound > 0, "TMessageFor needs types with a MaxEncodedSize.");
+		static_assert(Bound <= static_cast<std::size_t>(FMessage::MaxSize - FMessage::GetHeadSize()),
+			"these types can exceed FMessage::MaxSize.");
+
+		return FMessage::GetHeadSize() + static_cast<int>(Bound);
+	}
+
+	// a message whose inline buffer holds exactly its header and one PackBounded(ArgTypes...),
+	// checked against FMessage::MaxSize at compile time so it never spills or overflows.
+	//
+	//     TK::TMessageFor<FMove> Message(EMsg::Move);
+	//     Message.PackBounded(Move);
+	//     Message.UpdateHeader();
+	template<typename ...ArgTypes>
+	using TMessageFor = TMessage<MessageSizeFor<ArgTypes...>()>;
+}
@@ -1,6 +1,7 @@
 ﻿#pragma once
 #include <cstdint>    
 #include <type_traits> // ReSharper disable once CppUnusedIncludeDirective, false positive.
+#include "Serialization/Varint.h"
 
 namespace TK
 {
@@ -36,10 +37,44 @@ namespace TK
 
 		void MarkOutputInvalid() { bValidOutput = false; }
 
+		void SetIntEncoding(EIntEncoding Encoding) { IntEncoding = Encoding; }
+
+		EIntEncoding GetIntEncoding() const { return IntEncoding; }
+
 	protected:
 
 		virtual bool PushImpl(const void* Source, SizeType Length) = 0;
 		
 		bool bValidOutput {true};
+		EIntEncoding IntEncoding {EIntEncoding::Fixed};
+	};
+
+	// compile-time dispatched stream. concrete streams derive from TOutStream<Self> and provide
+	// bool PushBytes(const void*, SizeType). Push on the concrete type is resolved statically and
+	// can be inlined, while FOutStream& keeps working as the type-erased interface.
+	template<typename DerivedType>
+	class TOutStream : public FOutStream
+	{
+	public:
+
+		void Push(const void* Source, SizeType Length)
+		{
+			if(bValidOutput)
+				bValidOutput = static_cast<DerivedType*>(this)->PushBytes(Source, Length);
+		}
+
+		template<typename T, typename U, std::enable_if_t<std::is_integral_v<T>>* = nullptr>
+		void PushAs(U Data)
+		{
+			T AsInt = static_cast<T>(Data);
+			Push(&AsInt, sizeof(T));
+		}
+
+	protected:
+
+		virtual bool PushImpl(const void* Source, SizeType Length) override final
+		{
+			return static_cast<DerivedType*>(this)->PushBytes(Source, Length);
+		}
 	};
 }
@@ -0,0 +1,481 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstring>
+#include "Serialization/SerializeFuncs.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TK_QUANTIZE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define TK_QUANTIZE_F16C 1
+#include <immintrin.h>
+#endif
+
+namespace TK
+{
+	// float, float[N] and std::array<float, N> can be quantized.
+	template<typename T>
+	inline constexpr int FloatFieldSize = 0;
+
+	template<>
+	inline constexpr int FloatFieldSize<float> = 1;
+
+	template<std::size_t N>
+	inline constexpr int FloatFieldSize<float[N]> = static_cast<int>(N);
+
+	template<std::size_t N>
+	inline constexpr int FloatFieldSize<std::array<float, N>> = static_cast<int>(N);
+
+	template<typename T>
+	auto GetFloatFieldData(T& Field)
+	{
+		using FieldType = std::remove_const_t<T>;
+		static_assert(FloatFieldSize<FieldType> > 0, "only float, float[N] and std::array<float, N> are supported.");
+
+		if constexpr (std::is_same_v<FieldType, float>)
+		{
+			return &Field;
+		}
+		else if constexpr (std::is_array_v<FieldType>)
+		{
+			return &Field[0];
+		}
+		else
+		{
+			return Field.data();
+		}
+	}
+
+	inline std::uint32_t FloatBits(float Value)
+	{
+		std::uint32_t Bits;
+		std::memcpy(&Bits, &Value, sizeof(Bits));
+		return Bits;
+	}
+
+	inline float BitsToFloat(std::uint32_t Bits)
+	{
+		float Value;
+		std::memcpy(&Value, &Bits, sizeof(Value));
+		return Value;
+	}
+
+	// IEEE 754 binary16, round to nearest even. NaN stays NaN, overflow becomes infinity.
+	inline std::uint16_t FloatToHalf(float Value)
+	{
+		constexpr std::uint32_t Infinity = 255u << 23;
+		constexpr std::uint32_t HalfOverflow = (127u + 16) << 23;
+		constexpr std::uint32_t DenormMagic = ((127u - 15) + (23 - 10) + 1) << 23;
+
+		std::uint32_t Bits = FloatBits(Value);
+		std::uint32_t Sign = Bits & 0x80000000u;
+		Bits ^= Sign;
+
+		std::uint32_t Result;
+		if (Bits >= HalfOverflow)
+		{
+			Result = Bits > Infinity ? 0x7E00 : 0x7C00;
+		}
+		else if (Bits < (113u << 23))
+		{
+			float Aligned = BitsToFloat(Bits) + BitsToFloat(DenormMagic);
+			Result = FloatBits(Aligned) - DenormMagic;
+		}
+		else
+		{
+			std::uint32_t MantissaOdd = (Bits >> 13) & 1;
+			Bits += ((15u - 127u) << 23) + 0xFFF;
+			Bits += MantissaOdd;
+			Result = Bits >> 13;
+		}
+
+		return static_cast<std::uint16_t>(Result | (Sign >> 16));
+	}
+
+	inline float HalfToFloat(std::uint16_t Half)
+	{
+		constexpr std::uint32_t ShiftedExponent = 0x7C00u << 13;
+
+		std::uint32_t Bits = (Half & 0x7FFFu) << 13;
+		std::uint32_t Exponent = Bits & ShiftedExponent;
+		Bits += (127u - 15) << 23;
+
+		if (Exponent == ShiftedExponent)
+		{
+			Bits += (128u - 16) << 23;
+		}
+		else if (Exponent == 0)
+		{
+			Bits += 1u << 23;
+			Bits = FloatBits(BitsToFloat(Bits) - BitsToFloat(113u << 23));
+		}
+
+		return BitsToFloat(Bits | (static_cast<std::uint32_t>(Half & 0x8000u) << 16));
+	}
+
+	inline void FloatsToHalves(const float* Source, std::uint16_t* Dest, int Num)
+	{
+		int i = 0;
+#if TK_QUANTIZE_F16C
+		for (; i + 4 <= Num; i += 4)
+		{
+			__m128i Halves = _mm_cvtps_ph(_mm_loadu_ps(Source + i), _MM_FROUND_TO_NEAREST_INT);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(Dest + i), Halves);
+		}
+#endif
+		for (; i < Num; ++i)
+		{
+			Dest[i] = FloatToHalf(Source[i]);
+		}
+	}
+
+	inline void HalvesToFloats(const std::uint16_t* Source, float* Dest, int Num)
+	{
+		int i = 0;
+#if TK_QUANTIZE_F16C
+		for (; i + 4 <= Num; i += 4)
+		{
+			__m128i Halves = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(Source + i));
+			_mm_storeu_ps(Dest + i, _mm_cvtph_ps(Halves));
+		}
+#endif
+		for (; i < Num; ++i)
+		{
+			Dest[i] = HalfToFloat(Source[i]);
+		}
+	}
+
+	// fixed point over [Min, Max] with Bits in [1, 24]. values are clamped into the range,
+	// NaN maps to Max. the scalar and SSE2 paths produce identical results.
+	struct FQuantizer
+	{
+		FQuantizer(float InMin, float InMax, int InBits)
+			: Min(InMin), Max(InMax), Bits(InBits), Steps(static_cast<std::uint32_t>(LowBitsMask(InBits)))
+		{
+			Scale = static_cast<float>(Steps) / (Max - Min);
+			MaxScaled = static_cast<float>(Steps);
+			InvScale = (Max - Min) / static_cast<float>(Steps);
+		}
+
+		bool IsValid() const { return Bits >= 1 && Bits <= 24 && Min < Max; }
+
+		std::uint32_t Quantize(float Value) const
+		{
+			float Clamped = Value < Max ? Value : Max;
+			Clamped = Clamped > Min ? Clamped : Min;
+			// at 24 bits Max can round up to Steps + 1 in float
+			float Scaled = (Clamped - Min) * Scale + 0.5f;
+			return static_cast<std::uint32_t>(Scaled < MaxScaled ? Scaled : MaxScaled);
+		}
+
+		float Dequantize(std::uint32_t Value) const
+		{
+			return Min + static_cast<float>(Value) * InvScale;
+		}
+
+		void Quantize(const float* Source, std::uint32_t* Dest, int Num) const
+		{
+			int i = 0;
+#if TK_QUANTIZE_SSE2
+			const __m128 MinV = _mm_set1_ps(Min);
+			const __m128 MaxV = _mm_set1_ps(Max);
+			const __m128 ScaleV = _mm_set1_ps(Scale);
+			const __m128 Half = _mm_set1_ps(0.5f);
+			const __m128 MaxScaledV = _mm_set1_ps(MaxScaled);
+			for (; i + 4 <= Num; i += 4)
+			{
+				__m128 Value = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(Source + i), MaxV), MinV);
+				Value = _mm_min_ps(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(Value, MinV), ScaleV), Half), MaxScaledV);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(Dest + i), _mm_cvttps_epi32(Value));
+			}
+#endif
+			for (; i < Num; ++i)
+			{
+				Dest[i] = Quantize(Source[i]);
+			}
+		}
+
+		void Dequantize(const std::uint32_t* Source, float* Dest, int Num) const
+		{
+			int i = 0;
+#if TK_QUANTIZE_SSE2
+			const __m128 MinV = _mm_set1_ps(Min);
+			const __m128 InvScaleV = _mm_set1_ps(InvScale);
+			for (; i + 4 <= Num; i += 4)
+			{
+				__m128 Value = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Source + i)));
+				_mm_storeu_ps(Dest + i, _mm_add_ps(MinV, _mm_mul_ps(Value, InvScaleV)));
+			}
+#endif
+			for (; i < Num; ++i)
+			{
+				Dest[i] = Dequantize(Source[i]);
+			}
+		}
+
+		float Min;
+		float Max;
+		int Bits;
+		std::uint32_t Steps;
+		float Scale;
+		float InvScale;
+		float MaxScaled;
+	};
+
+	// TK::Quantized(Field, Min, Max, Bits) inside TK_SERIAL.
+	template<typename T>
+	struct TQuantizedRef
+	{
+		T& Value;
+		FQuantizer Quantizer;
+	};
+
+	template<typename T>
+	TQuantizedRef<T> Quantized(T& Value, float Min, float Max, int Bits)
+	{
+		return TQuantizedRef<T>{Value, FQuantizer(Min, Max, Bits)};
+	}
+
+	// TK::Half(Field) inside TK_SERIAL, 16 bits per float.
+	template<typename T>
+	struct THalfRef
+	{
+		T& Value;
+	};
+
+	template<typename T>
+	THalfRef<T> Half(T& Value)
+	{
+		return THalfRef<T>{Value};
+	}
+
+	// TK::SmallestThree(Rotation) for a unit quaternion stored as float[4] or std::array<float, 4>.
+	// the largest component is dropped and rebuilt on load, the other three are quantized over
+	// [-1/sqrt(2), 1/sqrt(2)]. the default 10 bits per component packs a rotation into 32 bits.
+	template<typename T>
+	struct TSmallestThreeRef
+	{
+		static_assert(FloatFieldSize<std::remove_const_t<T>> == 4, "smallest three needs exactly four floats.");
+
+		T& Value;
+		int BitsPerComponent;
+	};
+
+	template<typename T>
+	TSmallestThreeRef<T> SmallestThree(T& Value, int BitsPerComponent = 10)
+	{
+		return TSmallestThreeRef<T>{Value, BitsPerComponent};
+	}
+
+	template<typename T>
+	inline constexpr bool IsSerialProxy<TQuantizedRef<T>> = true;
+
+	template<typename T>
+	inline constexpr bool IsSerialProxy<THalfRef<T>> = true;
+
+	template<typename T>
+	inline constexpr bool IsSerialProxy<TSmallestThreeRef<T>> = true;
+
+	// arrays are converted in batches of this many floats
+	constexpr int QuantizeBatchSize = 64;
+
+	template<typename StreamType, typename T, std::enable_if_t<IsOutStream<StreamType>>* = nullptr>
+	void Save(StreamType& Stream, const TQuantizedRef<T>& Data)
+	{
+		const FQuantizer& Quantizer = Data.Quantizer;
+		if (!Quantizer.IsValid())
+		{
+			Stream.MarkOutputInvalid();
+			TK_ASSERT(false);
+			return;
+		}
+
+		const float* Source = GetFloatFieldData(Data.Value);
+		constexpr int Num = FloatFieldSize<std::remove_const_t<T>>;
+
+		std::uint32_t Batch[QuantizeBatchSize];
+		for (int Start = 0; Start < Num; Start += QuantizeBatchSize)
+		{
+			int Count = Num - Start < QuantizeBatchSize ? Num - Start : QuantizeBatchSize;
+			Quantizer.Quantize(Source + Start, Batch, Count);
+
+			if constexpr (IsBitStream<StreamType>)
+			{
+				for (int i = 0; i < Count; ++i)
+				{
+					Stream.WriteBits(Batch[i], Quantizer.Bits);
+				}
+			}
+			else
+			{
+				const int BytesPerValue = (Quantizer.Bits + 7) / 8;
+				char Bytes[QuantizeBatchSize * sizeof(std::uint32_t)];
+				for (int i = 0; i < Count; ++i)
+				{
+					std::memcpy(Bytes + i * BytesPerValue, &Batch[i], BytesPerValue);
+				}
+
+				Stream.Push(Bytes, Count * BytesPerValue);
+			}
+		}
+	}
+
+	template<typename StreamType, typename T, std::enable_if_t<IsInStream<StreamType>>* = nullptr>
+	void Load(StreamType& Stream, const TQuantizedRef<T>& Data)
+	{
+		const FQuantizer& Quantizer = Data.Quantizer;
+		if (!Quantizer.IsValid())
+		{
+			Stream.MarkInputInvalid();
+			return;
+		}
+
+		float* Dest = GetFloatFieldData(Data.Value);
+		constexpr int Num = FloatFieldSize<T>;
+
+		std::uint32_t Batch[QuantizeBatchSize];
+		for (int Start = 0; Start < Num; Start += QuantizeBatchSize)
+		{
+			int Count = Num - Start < QuantizeBatchSize ? Num - Start : QuantizeBatchSize;
+			if constexpr (IsBitStream<StreamType>)
+			{
+				for (int i = 0; i < Count; ++i)
+				{
+					Batch[i] = static_cast<std::uint32_t>(Stream.ReadBits(Quantizer.Bits));
+				}
+			}
+			else
+			{
+				const int BytesPerValue = (Quantizer.Bits + 7) / 8;
+				char Bytes[QuantizeBatchSize * sizeof(std::uint32_t)];
+				Stream.Pop(Bytes, Count * BytesPerValue);
+
+				for (int i = 0; i < Count; ++i)
+				{
+					Batch[i] = 0;
+					std::memcpy(&Batch[i], Bytes + i * BytesPerValue, BytesPerValue);
+
+					if (Batch[i] > Quantizer.Steps)
+						Stream.MarkInputInvalid();
+				}
+			}
+
+			if (!Stream.IsValidInput())
+				return;
+
+			Quantizer.Dequantize(Batch, Dest + Start, Count);
+		}
+	}
+
+	template<typename StreamType, typename T, std::enable_if_t<IsOutStream<StreamType>>* = nullptr>
+	void Save(StreamType& Stream, const THalfRef<T>& Data)
+	{
+		const float* Source = GetFloatFieldData(Data.Value);
+		constexpr int Num = FloatFieldSize<std::remove_const_t<T>>;
+
+		std::uint16_t Batch[QuantizeBatchSize];
+		for (int Start = 0; Start < Num; Start += QuantizeBatchSize)
+		{
+			int Count = Num - Start < QuantizeBatchSize ? Num - Start : QuantizeBatchSize;
+			FloatsToHalves(Source + Start, Batch, Count);
+			Stream.Push(Batch, Count * sizeof(std::uint16_t));
+		}
+	}
+
+	template<typename StreamType, typename T, std::enable_if_t<IsInStream<StreamType>>* = nullptr>
+	void Load(StreamType& Stream, const THalfRef<T>& Data)
+	{
+		float* Dest = GetFloatFieldData(Data.Value);
+		constexpr int Num = FloatFieldSize<T>;
+
+		std::uint16_t Batch[QuantizeBatchSize];
+		for (int Start = 0; Start < Num; Start += QuantizeBatchSize)
+		{
+			int Count = Num - Start < QuantizeBatchSize ? Num - Start : QuantizeBatchSize;
+			Stream.Pop(Batch, Count * sizeof(std::uint16_t));
+
+			if (!Stream.IsValidInput())
+				return;
+
+			HalvesToFloats(Batch, Dest + Start, Count);
+		}
+	}
+
+	template<typename StreamType, typename T, std::enable_if_t<IsOutStream<StreamType>>* = nullptr>
+	void Save(StreamType& Stream, const TSmallestThreeRef<T>& Data)
+	{
+		const int Bits = Data.BitsPerComponent;
+		if (Bits < 2 || Bits > 20)
+		{
+			Stream.MarkOutputInvalid();
+			TK_ASSERT(false);
+			return;
+		}
+
+		const float* Source = GetFloatFieldData(Data.Value);
+
+		int Largest = 0;
+		for (int i = 1; i < 4; ++i)
+		{
+			if (std::fabs(Source[i]) > std::fabs(Source[Largest]))
+				Largest = i;
+		}
+
+		// q and -q are the same rotation, flip so the dropped component is positive
+		const float Sign = Source[Largest] < 0.0f ? -1.0f : 1.0f;
+		const FQuantizer Quantizer(-0.70710678f, 0.70710678f, Bits);
+
+		std::uint64_t Packed = static_cast<std::uint64_t>(Largest);
+		int Shift = 2;
+		for (int i = 0; i < 4; ++i)
+		{
+			if (i == Largest)
+				continue;
+
+			Packed |= static_cast<std::uint64_t>(Quantizer.Quantize(Source[i] * Sign)) << Shift;
+			Shift += Bits;
+		}
+
+		SaveBits(Stream, Packed, 2 + 3 * Bits);
+	}
+
+	template<typename StreamType, typename T, std::enable_if_t<IsInStream<StreamType>>* = nullptr>
+	void Load(StreamType& Stream, const TSmallestThreeRef<T>& Data)
+	{
+		const int Bits = Data.BitsPerComponent;
+		if (Bits < 2 || Bits > 20)
+		{
+			Stream.MarkInputInvalid();
+			return;
+		}
+
+		std::uint64_t Packed = LoadBits(Stream, 2 + 3 * Bits);
+		if (!Stream.IsValidInput() || Packed > LowBitsMask(2 + 3 * Bits))
+		{
+			Stream.MarkInputInvalid();
+			return;
+		}
+
+		const FQuantizer Quantizer(-0.70710678f, 0.70710678f, Bits);
+		const int Largest = static_cast<int>(Packed & 3);
+
+		float Components[4];
+		float SquaredSum = 0.0f;
+		int Shift = 2;
+		for (int i = 0; i < 4; ++i)
+		{
+			if (i == Largest)
+				continue;
+
+			Components[i] = Quantizer.Dequantize(static_cast<std::uint32_t>((Packed >> Shift) & LowBitsMask(Bits)));
+			SquaredSum += Components[i] * Components[i];
+			Shift += Bits;
+		}
+
+		Components[Largest] = std::sqrt(SquaredSum < 1.0f ? 1.0f - SquaredSum : 0.0f);
+		std::memcpy(GetFloatFieldData(Data.Value), Components, sizeof(Components));
+	}
+}
@@ -0,0 +1,270 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "Serialization/OutStream.h"
+#include "Serialization/InStream.h"
+#include "TinkerAssert.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/uio.h>
+#endif
+
+namespace TK
+{
+	// one contiguous piece of a segmented buffer. on POSIX it has the layout of iovec, so a slice
+	// list can be handed to writev/sendmsg as is.
+	struct FIoSlice
+	{
+		const void* Data;
+		std::size_t Size;
+	};
+
+#if defined(__unix__) || defined(__APPLE__)
+	static_assert(sizeof(FIoSlice) == sizeof(iovec) && offsetof(FIoSlice, Size) == offsetof(iovec, iov_len),
+		"FIoSlice must match iovec.");
+#endif
+
+	// per thread free list of segments, so writers built and dropped in a loop stop hitting malloc.
+	template<int SegmentSize>
+	class TSegmentPool
+	{
+	public:
+
+		static constexpr std::size_t MaxCached = 256;
+
+		static TSegmentPool& Get()
+		{
+			thread_local TSegmentPool Pool;
+			return Pool;
+		}
+
+		std::unique_ptr<char[]> Acquire()
+		{
+			if (Free.empty())
+				return std::unique_ptr<char[]>(new char[SegmentSize]);
+
+			std::unique_ptr<char[]> Segment = std::move(Free.back());
+			Free.pop_back();
+			return Segment;
+		}
+
+		void Release(std::unique_ptr<char[]> Segment)
+		{
+			if (Segment && Free.size() < MaxCached)
+				Free.push_back(std::move(Segment));
+		}
+
+		std::size_t GetCachedNum() const { return Free.size(); }
+
+	private:
+
+		std::vector<std::unique_ptr<char[]>> Free;
+	};
+
+	// appends into a chain of fixed size segments, written bytes are never moved again.
+	// the result is read back through GetSlices() or FSegmentedReader, or flattened with CopyTo().
+	template<int SegmentSize = 64 * 1024>
+	class TSegmentedWriter : public TOutStream<TSegmentedWriter<SegmentSize>>
+	{
+		static_assert(SegmentSize > 0, "SegmentSize must be positive.");
+
+		friend class TOutStream<TSegmentedWriter>;
+
+	public:
+
+		using SizeType = FOutStream::SizeType;
+		using PoolType = TSegmentPool<SegmentSize>;
+
+		TSegmentedWriter() = default;
+
+		~TSegmentedWriter() override { ReleaseSegments(); }
+
+		TSegmentedWriter(const TSegmentedWriter&) = delete;
+		TSegmentedWriter(TSegmentedWriter&&) = default;
+
+		TSegmentedWriter& operator=(const TSegmentedWriter&) = delete;
+
+		TSegmentedWriter& operator=(TSegmentedWriter&& Other) noexcept
+		{
+			if (this != &Other)
+			{
+				ReleaseSegments();
+				FOutStream::operator=(std::move(Other));
+				Segments = std::move(Other.Segments);
+				TailSize = Other.TailSize;
+				Other.TailSize = 0;
+			}
+			return *this;
+		}
+
+		std::size_t GetSize() const
+		{
+			return Segments.empty() ? 0 : (Segments.size() - 1) * SegmentSize + TailSize;
+		}
+
+		std::size_t GetSegmentNum() const { return Segments.size(); }
+
+		void GetSlices(std::vector<FIoSlice>& Slices) const
+		{
+			Slices.clear();
+			for (std::size_t i = 0; i < Segments.size(); ++i)
+			{
+				std::size_t Size = i + 1 == Segments.size() ? TailSize : SegmentSize;
+				if (Size > 0)
+					Slices.push_back({Segments[i].get(), Size});
+			}
+		}
+
+		std::vector<FIoSlice> GetSlices() const
+		{
+			std::vector<FIoSlice> Slices;
+			GetSlices(Slices);
+			return Slices;
+		}
+
+		// Dest must have room for GetSize() bytes.
+		void CopyTo(char* Dest) const
+		{
+			for (std::size_t i = 0; i < Segments.size(); ++i)
+			{
+				std::size_t Size = i + 1 == Segments.size() ? TailSize : SegmentSize;
+				std::memcpy(Dest, Segments[i].get(), Size);
+				Dest += Size;
+			}
+		}
+
+		// rewrites Length bytes already written at Offset, across segment boundaries. used to fill
+		// in reserved length prefixes, the bytes are never moved so varint slots stay padded.
+		void Overwrite(std::size_t Offset, const void* Source, std::size_t Length)
+		{
+			TK_ASSERT(Offset <= GetSize() && Length <= GetSize() - Offset);
+
+			auto Bytes = static_cast<const char*>(Source);
+			while (Length > 0)
+			{
+				std::size_t InSegment = Offset % SegmentSize;
+				std::size_t Chunk = SegmentSize - InSegment < Length ? SegmentSize - InSegment : Length;
+				std::memcpy(Segments[Offset / SegmentSize].get() + InSegment, Bytes, Chunk);
+
+				Offset += Chunk;
+				Bytes += Chunk;
+				Length -= Chunk;
+			}
+		}
+
+		// segments go back to the pool.
+		void Clear()
+		{
+			this->bValidOutput = true;
+			ReleaseSegments();
+		}
+
+	protected:
+
+		bool PushBytes(const void* Source, SizeType Length)
+		{
+			if (Length <= 0)
+				return true;
+
+			auto Bytes = static_cast<const char*>(Source);
+			auto Remained = static_cast<std::size_t>(Length);
+
+			while (Remained > 0)
+			{
+				if (Segments.empty() || TailSize == SegmentSize)
+				{
+					Segments.push_back(PoolType::Get().Acquire());
+					TailSize = 0;
+				}
+
+				std::size_t Chunk = SegmentSize - TailSize < Remained ? SegmentSize - TailSize : Remained;
+				std::memcpy(Segments.back().get() + TailSize, Bytes, Chunk);
+
+				TailSize += Chunk;
+				Bytes += Chunk;
+				Remained -= Chunk;
+			}
+			return true;
+		}
+
+		void ReleaseSegments()
+		{
+			for (auto& Segment : Segments)
+			{
+				PoolType::Get().Release(std::move(Segment));
+			}
+
+			Segments.clear();
+			TailSize = 0;
+		}
+
+		std::vector<std::unique_ptr<char[]>> Segments;
+		std::size_t TailSize {0};
+	};
+
+	using FSegmentedWriter = TSegmentedWriter<>;
+
+	// reads a slice list front to back across slice boundaries. the slices are copied,
+	// the memory they point to is not and has to outlive the reader.
+	class FSegmentedReader : public TInStream<FSegmentedReader>
+	{
+		friend class TInStream<FSegmentedReader>;
+
+	public:
+
+		FSegmentedReader() = default;
+
+		explicit FSegmentedReader(std::vector<FIoSlice> InSlices) : Slices(std::move(InSlices))
+		{
+			for (const FIoSlice& Slice : Slices)
+			{
+				Unread += static_cast<SizeType>(Slice.Size);
+			}
+		}
+
+		SizeType GetUnreadBytes() const { return Unread; }
+
+		virtual bool EnsureEnoughBytes(SizeType BytesNum) const override
+		{
+			return BytesNum >= 0 && Unread >= BytesNum;
+		}
+
+	protected:
+
+		bool PopBytes(void* Dest, SizeType Length)
+		{
+			if (Length < 0 || Length > Unread)
+				return false;
+
+			auto Bytes = static_cast<char*>(Dest);
+			auto Remained = static_cast<std::size_t>(Length);
+
+			while (Remained > 0)
+			{
+				const FIoSlice& Slice = Slices[Current];
+				std::size_t Chunk = Slice.Size - Offset < Remained ? Slice.Size - Offset : Remained;
+				std::memcpy(Bytes, static_cast<const char*>(Slice.Data) + Offset, Chunk);
+
+				Bytes += Chunk;
+				Remained -= Chunk;
+				Offset += Chunk;
+
+				if (Offset == Slice.Size)
+				{
+					++Current;
+					Offset = 0;
+				}
+			}
+
+			Unread -= Length;
+			return true;
+		}
+
+		std::vector<FIoSlice> Slices;
+		std::size_t Current {0};
+		std::size_t Offset {0};
+		SizeType Unread {0};
+	};
+}
@@ -1,4 +1,6 @@
 #pragma once
+#include <tuple>
+#include <type_traits>
 
 namespace TK
 {
@@ -11,6 +13,10 @@ namespace TK
 	template<>
 	inline constexpr bool IsBitwisePackable<double> = sizeof(double) == 8;
 
+	// reference wrappers such as TK::Ranged<0, 7>(Field), they reach the streams as rvalues.
+	template<typename T>
+	inline constexpr bool IsSerialProxy = false;
+
 	template<typename, typename StreamType, typename = void>
 	inline constexpr bool CanBeSaved = false;
 
@@ -25,12 +31,38 @@ namespace TK
 	inline constexpr bool CanBeLoaded<T, StreamType,
 	std::void_t<decltype(std::declval<T>().Load(std::declval<StreamType&>()))>> = true;
 
+	// streams a tuple of fields in order, defined in SerializeFuncs.h. runs of plain numbers and
+	// arrays of them are pushed and popped as one block with the same bytes.
+	template<typename StreamType, typename TupleType>
+	void StreamFields(StreamType& Stream, TupleType&& Fields);
+
 	template<typename T, typename...ArgTypes>
 	void Streaming(T& Stream, ArgTypes&&... Args)
 	{
-		(Stream & ... & std::forward<ArgTypes>(Args));
+		StreamFields(Stream, std::forward_as_tuple(std::forward<ArgTypes>(Args)...));
+	}
+
+	// fields keep referring to the object, proxies like TK::Ranged(Field) are stored by value.
+	template<typename...ArgTypes>
+	std::tuple<ArgTypes...> MakeSerialFields(ArgTypes&&... Args)
+	{
+		return std::tuple<ArgTypes...>(std::forward<ArgTypes>(Args)...);
 	}
 
+	template<typename T, typename = void>
+	inline constexpr bool HasSerialFields = false;
+
+	template<typename T>
+	inline constexpr bool HasSerialFields<T, std::void_t<decltype(std::declval<T&>().SerialFields())>> = true;
+
+	// types encoded as nothing but their SerialFields() in order, as TK_SERIAL does. others such
+	// as TK_SERIAL_TAGGED declare SerialTagged and are kept off layout based fast paths.
+	template<typename T, typename = void>
+	inline constexpr bool HasPositionalFields = HasSerialFields<const T>;
+
+	template<typename T>
+	inline constexpr bool HasPositionalFields<T, std::void_t<typename T::SerialTagged>> = false;
+
 	#define TK_SERIAL(...) \
 	template<typename T>\
 	void Load(T& Stream)\
@@ -41,5 +73,13 @@ namespace TK
 	void Save(T& Stream) const\
 	{\
 		TK::Streaming(Stream, __VA_ARGS__);\
+	}\
+	auto SerialFields()\
+	{\
+		return TK::MakeSerialFields(__VA_ARGS__);\
+	}\
+	auto SerialFields() const\
+	{\
+		return TK::MakeSerialFields(__VA_ARGS__);\
 	}
 }
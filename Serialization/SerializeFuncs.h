@@ -1,22 +1,400 @@
 ﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <tuple>
+#include <utility>
+#include <string>
 #include <string_view>
 #include <vector>
 #include <map>
+#include <memory>
 #include <array>
+#include "Serialization/ArrayView.h"
 #include "Serialization/OutStream.h"
 #include "Serialization/InStream.h"
 #include "Serialization/MemoryReader.h"
+#include "Serialization/BitStream.h"
 #include "Serialization/SerializeDefines.h"
 #include "TinkerAssert.h"
 
 namespace TK
 {
+	template<typename StreamType>
+	inline constexpr bool IsOutStream = std::is_base_of_v<FOutStream, StreamType>;
+
+	template<typename StreamType>
+	inline constexpr bool IsInStream = std::is_base_of_v<FInStream, StreamType>;
+
+	// readers that expose their whole buffer through GetReadPos()/Advance()
+	template<typename StreamType>
+	inline constexpr bool IsMemReader = std::is_base_of_v<FMemReader, StreamType>;
+
+	// std::pmr containers, and types declaring an allocator_type with a constructor taking one
+	template<typename T, typename AllocatorType>
+	inline constexpr bool IsAllocatorAware = std::uses_allocator_v<T, AllocatorType> && std::is_constructible_v<T, const AllocatorType&>;
+
+	// a T that allocates from Allocator when it is allocator aware, so temporaries moved into a
+	// container need no copy.
+	template<typename T, typename AllocatorType>
+	T MakeWithAllocator(const AllocatorType& Allocator)
+	{
+		if constexpr (IsAllocatorAware<T, AllocatorType>)
+		{
+			return T(Allocator);
+		}
+		else
+		{
+			return T {};
+		}
+	}
+
+	// how a TK_SERIAL field maps to memory. bRaw means its field by field encoding equals its
+	// bytes, bIntegers means that only holds in fixed mode. bools are left out because bit
+	// streams shrink them and loading raw bytes into them is undefined.
+	template<typename T, typename = void>
+	struct TRawLayout
+	{
+		static constexpr bool bRaw = false;
+		static constexpr bool bIntegers = false;
+	};
+
+	template<typename T>
+	struct TRawLayout<T, std::enable_if_t<IsBitwisePackable<T> && !std::is_same_v<T, bool>>>
+	{
+		static constexpr bool bRaw = true;
+		static constexpr bool bIntegers = IsVarintEncodable<T>;
+	};
+
+	template<typename T>
+	struct TRawLayout<T, std::enable_if_t<std::is_enum_v<T>>> : TRawLayout<std::underlying_type_t<T>> {};
+
+	template<typename T, std::size_t N>
+	struct TRawLayout<T[N]> : TRawLayout<T> {};
+
+	template<typename T, typename TupleType, typename = std::make_index_sequence<std::tuple_size_v<TupleType>>>
+	struct TRawFieldsLayout;
+
+	template<typename T, typename TupleType, std::size_t... Indices>
+	struct TRawFieldsLayout<T, TupleType, std::index_sequence<Indices...>>
+	{
+		template<std::size_t I>
+		using FieldType = std::remove_cv_t<std::remove_reference_t<std::tuple_element_t<I, TupleType>>>;
+
+		static constexpr bool bRaw = (std::is_lvalue_reference_v<std::tuple_element_t<Indices, TupleType>> && ...) &&
+			(TRawLayout<FieldType<Indices>>::bRaw && ...) && (sizeof(FieldType<Indices>) + ... + 0) == sizeof(T);
+		static constexpr bool bIntegers = (TRawLayout<FieldType<Indices>>::bIntegers || ...);
+	};
+
+	// TK_SERIAL structs whose fields are all raw and fill the struct without padding.
+	template<typename T>
+	struct TRawLayout<T, std::enable_if_t<HasPositionalFields<T>>> : TRawFieldsLayout<T, decltype(std::declval<const T&>().SerialFields())>
+	{
+		static constexpr bool bRaw = std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T> &&
+			TRawFieldsLayout<T, decltype(std::declval<const T&>().SerialFields())>::bRaw;
+	};
+
+	template<typename T>
+	inline constexpr bool IsTriviallySerializable = HasPositionalFields<T> && TRawLayout<T>::bRaw;
+
+	template<typename T>
+	bool HasSerialLayout();
+
+	// nested TK_SERIAL members, arrays of them included, must list their own fields in order too.
+	template<typename T>
+	bool HasNestedSerialLayout()
+	{
+		if constexpr (std::is_array_v<T>)
+		{
+			return HasNestedSerialLayout<std::remove_extent_t<T>>();
+		}
+		else if constexpr (HasPositionalFields<T>)
+		{
+			return HasSerialLayout<T>();
+		}
+		else
+		{
+			return true;
+		}
+	}
+
+	// the compile time check cannot see field order, so the offsets are compared once per type.
+	template<typename T>
+	bool HasSerialLayout()
+	{
+		static const bool bInOrder = []
+		{
+			T Probe {};
+			bool bMatched = true;
+			std::size_t Offset = 0;
+			auto Base = reinterpret_cast<const char*>(&Probe);
+
+			std::apply([&](const auto&... Fields)
+			{
+				((bMatched = bMatched && reinterpret_cast<const char*>(&Fields) - Base == static_cast<std::ptrdiff_t>(Offset),
+					Offset += sizeof(Fields)), ...);
+
+				bMatched = bMatched && (HasNestedSerialLayout<std::remove_cv_t<std::remove_reference_t<decltype(Fields)>>>() && ...);
+			}, std::as_const(Probe).SerialFields());
+
+			return bMatched;
+		}();
+		return bInOrder;
+	}
+
+	// whether a run of T can be pushed as raw bytes, integers are not raw in varint mode.
+	template<typename T, typename StreamType>
+	bool IsRawEncoded(const StreamType& Stream)
+	{
+		if constexpr (IsTriviallySerializable<T>)
+		{
+			return (!TRawLayout<T>::bIntegers || Stream.GetIntEncoding() == EIntEncoding::Fixed) && HasSerialLayout<T>();
+		}
+		else if constexpr (!IsBitwisePackable<T>)
+		{
+			return false;
+		}
+		else if constexpr (IsVarintEncodable<T>)
+		{
+			return Stream.GetIntEncoding() == EIntEncoding::Fixed;
+		}
+		else
+		{
+			return true;
+		}
+	}
+
+	// encoded size of T on byte streams when it never varies, 0 otherwise. bIntegers means the
+	// size only holds in fixed mode.
+	template<typename T, typename = void>
+	struct TFixedSize
+	{
+		static constexpr std::size_t Size = 0;
+		static constexpr bool bIntegers = false;
+	};
+
+	template<typename T>
+	struct TFixedSize<T, std::enable_if_t<IsBitwisePackable<T>>>
+	{
+		static constexpr std::size_t Size = std::is_same_v<T, bool> ? 1 : sizeof(T);
+		static constexpr bool bIntegers = IsVarintEncodable<T>;
+	};
+
+	template<typename T>
+	struct TFixedSize<T, std::enable_if_t<std::is_enum_v<T>>> : TFixedSize<std::underlying_type_t<T>> {};
+
+	template<typename T, std::size_t N>
+	struct TFixedSize<T[N]>
+	{
+		static constexpr std::size_t Size = TFixedSize<T>::Size * N;
+		static constexpr bool bIntegers = TFixedSize<T>::bIntegers;
+	};
+
+	template<typename T, std::size_t N>
+	struct TFixedSize<std::array<T, N>> : TFixedSize<T[N]> {};
+
+	template<typename T, auto Min, auto Max>
+	struct TFixedSize<TRangedRef<T, Min, Max>> : TFixedSize<std::remove_const_t<T>> {};
+
+	template<typename TupleType, typename = std::make_index_sequence<std::tuple_size_v<TupleType>>>
+	struct TFixedFieldsSize;
+
+	template<typename TupleType, std::size_t... Indices>
+	struct TFixedFieldsSize<TupleType, std::index_sequence<Indices...>>
+	{
+		template<std::size_t I>
+		using FieldType = std::remove_cv_t<std::remove_reference_t<std::tuple_element_t<I, TupleType>>>;
+
+		static constexpr bool bFixed = ((TFixedSize<FieldType<Indices>>::Size > 0) && ...);
+		static constexpr std::size_t Size = bFixed ? (TFixedSize<FieldType<Indices>>::Size + ... + 0) : 0;
+		static constexpr bool bIntegers = (TFixedSize<FieldType<Indices>>::bIntegers || ...);
+	};
+
+	template<typename T>
+	struct TFixedSize<T, std::enable_if_t<HasPositionalFields<T>>> : TFixedFieldsSize<decltype(std::declval<const T&>().SerialFields())> {};
+
+	template<typename T>
+	inline constexpr std::size_t FixedEncodedSize = TFixedSize<T>::Size;
+
+	// most bytes T can take on byte streams in either int encoding, 0 when it has no bound.
+	// integers count as their longest varint.
+	template<typename T, typename = void>
+	struct TMaxSize
+	{
+		static constexpr std::size_t Size = 0;
+	};
+
+	template<typename T>
+	struct TMaxSize<T, std::enable_if_t<IsBitwisePackable<T>>>
+	{
+		static constexpr std::size_t Size = IsVarintEncodable<T> && static_cast<std::size_t>(MaxVarintBytes<T>) > sizeof(T) ?
+			static_cast<std::size_t>(MaxVarintBytes<T>) : TFixedSize<T>::Size;
+	};
+
+	template<typename T>
+	struct TMaxSize<T, std::enable_if_t<std::is_enum_v<T>>> : TMaxSize<std::underlying_type_t<T>> {};
+
+	template<typename T, std::size_t N>
+	struct TMaxSize<T[N]>
+	{
+		static constexpr std::size_t Size = TMaxSize<T>::Size * N;
+	};
+
+	template<typename T, std::size_t N>
+	struct TMaxSize<std::array<T, N>> : TMaxSize<T[N]> {};
+
+	template<typename T, auto Min, auto Max>
+	struct TMaxSize<TRangedRef<T, Min, Max>> : TMaxSize<std::remove_const_t<T>> {};
+
+	template<typename TupleType, typename = std::make_index_sequence<std::tuple_size_v<TupleType>>>
+	struct TMaxFieldsSize;
+
+	template<typename TupleType, std::size_t... Indices>
+	struct TMaxFieldsSize<TupleType, std::index_sequence<Indices...>>
+	{
+		template<std::size_t I>
+		using FieldType = std::remove_cv_t<std::remove_reference_t<std::tuple_element_t<I, TupleType>>>;
+
+		static constexpr bool bBounded = ((TMaxSize<FieldType<Indices>>::Size > 0) && ...);
+		static constexpr std::size_t Size = bBounded ? (TMaxSize<FieldType<Indices>>::Size + ... + 0) : 0;
+	};
+
+	template<typename T>
+	struct TMaxSize<T, std::enable_if_t<HasPositionalFields<T>>> : TMaxFieldsSize<decltype(std::declval<const T&>().SerialFields())> {};
+
+	template<typename T>
+	inline constexpr std::size_t MaxEncodedSize = TMaxSize<std::remove_cv_t<std::remove_reference_t<T>>>::Size;
+
+	template<typename StreamType, typename T>
+	void SaveVarint(StreamType& Stream, T Value)
+	{
+		std::uint8_t Buffer[MaxVarintBytes<std::uint64_t>];
+		Stream.Push(Buffer, EncodeVarint(ToVarint(Value), Buffer));
+	}
+
+	template<typename StreamType, typename T>
+	void LoadVarint(StreamType& Stream, T& Value)
+	{
+		if (!Stream.IsValidInput())
+			return;
+
+		std::uint64_t Raw = 0;
+		if constexpr (IsMemReader<StreamType>)
+		{
+			auto Source = static_cast<const std::uint8_t*>(Stream.GetReadPos());
+			int Bytes = DecodeVarint(Source, Stream.GetUnreadBytes(), Raw, MaxVarintBytes<T>);
+			if (Bytes == 0)
+			{
+				Stream.MarkInputInvalid();
+				return;
+			}
+
+			Stream.Advance(Bytes);
+		}
+		else
+		{
+			std::uint8_t Buffer[MaxVarintBytes<T>];
+			int Bytes = 0;
+			do
+			{
+				if (Bytes == MaxVarintBytes<T>)
+				{
+					Stream.MarkInputInvalid();
+					return;
+				}
+
+				Stream.Pop(&Buffer[Bytes], 1);
+				if (!Stream.IsValidInput())
+					return;
+			}
+			while (Buffer[Bytes++] & 0x80);
+
+			if (DecodeVarint(Buffer, Bytes, Raw, MaxVarintBytes<T>) == 0)
+			{
+				Stream.MarkInputInvalid();
+				return;
+			}
+		}
+
+		if (!FromVarint(Raw, Value))
+			Stream.MarkInputInvalid();
+	}
+
+	// the low Bits bits of Value, exactly Bits on bit streams and rounded up to whole bytes elsewhere.
+	template<typename StreamType>
+	void SaveBits(StreamType& Stream, std::uint64_t Value, int Bits)
+	{
+		if constexpr (IsBitStream<StreamType>)
+		{
+			Stream.WriteBits(Value, Bits);
+		}
+		else
+		{
+			Value &= LowBitsMask(Bits);
+			Stream.Push(&Value, (Bits + 7) / 8);
+		}
+	}
+
+	template<typename StreamType>
+	std::uint64_t LoadBits(StreamType& Stream, int Bits)
+	{
+		if constexpr (IsBitStream<StreamType>)
+		{
+			return Stream.ReadBits(Bits);
+		}
+		else
+		{
+			std::uint64_t Value = 0;
+			Stream.Pop(&Value, (Bits + 7) / 8);
+			return Value;
+		}
+	}
+
+	// container length prefix, uint32 in fixed mode.
+	template<typename StreamType, typename SizeType>
+	void SaveSize(StreamType& Stream, SizeType Num)
+	{
+		if (Stream.GetIntEncoding() == EIntEncoding::Varint)
+		{
+			SaveVarint(Stream, static_cast<std::uint32_t>(Num));
+		}
+		else
+		{
+			Stream.template PushAs<std::uint32_t>(Num);
+		}
+	}
+
+	template<typename StreamType>
+	std::uint32_t LoadSize(StreamType& Stream)
+	{
+		std::uint32_t Num = 0;
+		if (Stream.GetIntEncoding() == EIntEncoding::Varint)
+		{
+			LoadVarint(Stream, Num);
+		}
+		else
+		{
+			Stream.template PopAs<std::uint32_t>(Num);
+		}
+		return Num;
+	}
+	
 	template <typename OutStreamType, typename T,
 		std::enable_if_t<IsBitwisePackable<T> || CanBeSaved<T, OutStreamType>>* = nullptr>
 	void Save(OutStreamType& Stream, const T& Data)
 	{
 		if constexpr (IsBitwisePackable<T>)
 		{
+			if constexpr (IsVarintEncodable<T>)
+			{
+				if (Stream.GetIntEncoding() == EIntEncoding::Varint)
+				{
+					SaveVarint(Stream, Data);
+					return;
+				}
+			}
+
 			Stream.Push(&Data, sizeof(Data));
 		}
 		else
@@ -25,35 +403,177 @@ namespace TK
 		}
 	}
 
+	// fixed size objects are bounds checked once, then their fields are popped unchecked.
+	template<typename StreamType, typename T>
+	void LoadBlock(StreamType& Stream, T& Data)
+	{
+		constexpr std::size_t Size = FixedEncodedSize<T>;
+
+		if (TFixedSize<T>::bIntegers && Stream.GetIntEncoding() != EIntEncoding::Fixed)
+		{
+			Data.Load(Stream);
+			return;
+		}
+
+		if (!Stream.IsValidInput())
+			return;
+
+		if (!Stream.EnsureEnoughBytes(Size))
+		{
+			Stream.MarkInputInvalid();
+			return;
+		}
+
+		FMemBlockReader Block(Stream.GetReadPos(), Size);
+		Data.Load(Block);
+
+		// a Load reading less than TFixedSize says is a mismatch as well
+		if (Block.IsValidInput() && Block.GetUnreadBytes() == 0)
+		{
+			Stream.Advance(Size);
+		}
+		else
+		{
+			Stream.MarkInputInvalid();
+		}
+	}
+
 	template <typename InStreamType, typename T,
 		std::enable_if_t<IsBitwisePackable<T> || CanBeLoaded<T, InStreamType>>* = nullptr>
 	void Load(InStreamType& Stream, T& Data)
 	{
 		if constexpr (IsBitwisePackable<T>)
 		{
+			if constexpr (IsVarintEncodable<T>)
+			{
+				if (Stream.GetIntEncoding() == EIntEncoding::Varint)
+				{
+					LoadVarint(Stream, Data);
+					return;
+				}
+			}
+
 			Stream.Pop(&Data, sizeof(Data));	
 		}
+		else if constexpr (IsMemReader<InStreamType> && FixedEncodedSize<T> > 0)
+		{
+			LoadBlock(Stream, Data);
+		}
 		else
 		{
 			Data.Load(Stream);		
 		}
 	}
 	
-	template<typename StreamType, typename T, std::enable_if_t<std::is_base_of_v<FOutStream, StreamType>>* = nullptr>
+	template<typename StreamType, typename T, std::enable_if_t<IsOutStream<StreamType>>* = nullptr>
     void Serialize(StreamType& Stream, const T& Data)
     {
     	using namespace TK;
     	Save(Stream, Data);
     }
     
-    template<typename StreamType, typename T, std::enable_if_t<std::is_base_of_v<FInStream, StreamType>>* = nullptr>
+    template<typename StreamType, typename T, std::enable_if_t<IsInStream<StreamType>>* = nullptr>
     void Serialize(StreamType& Stream, T& Data)
     {
     	using namespace TK;
     	Load(Stream, Data);
     }
 	
-	template<typename StreamType, typename T, std::enable_if_t<std::is_base_of_v<FOutStream, StreamType>>* = nullptr>
+	// a field whose bytes are its encoding, at least in fixed mode when bIntegers. structs are
+	// left out since their layout is only checked at run time.
+	template<typename T, typename = void>
+	struct TFusedField
+	{
+		static constexpr bool bFusable = false;
+		static constexpr bool bIntegers = false;
+	};
+
+	template<typename T>
+	struct TFusedField<T, std::enable_if_t<TRawLayout<T>::bRaw && !HasPositionalFields<std::remove_all_extents_t<T>>>>
+	{
+		static constexpr bool bFusable = true;
+		static constexpr bool bIntegers = TRawLayout<T>::bIntegers;
+	};
+
+	// proxies reach Streaming as rvalues and never fuse.
+	template<typename ArgType>
+	inline constexpr bool IsFusedArg = std::is_lvalue_reference_v<ArgType> &&
+		TFusedField<std::remove_cv_t<std::remove_reference_t<ArgType>>>::bFusable;
+
+	template<typename TupleType, std::size_t... Indices>
+	constexpr std::size_t FusedRunEnd(std::size_t Begin, std::index_sequence<Indices...>)
+	{
+		constexpr bool Fusable[] = { IsFusedArg<std::tuple_element_t<Indices, TupleType>>..., false };
+
+		std::size_t End = Begin;
+		while (Fusable[End])
+		{
+			++End;
+		}
+		return End;
+	}
+
+	template<std::size_t Begin, typename StreamType, typename TupleType, std::size_t... Indices>
+	void StreamFusedRun(StreamType& Stream, TupleType& Fields, std::index_sequence<Indices...>)
+	{
+		constexpr bool bIntegers = (TFusedField<std::remove_cv_t<std::remove_reference_t<std::tuple_element_t<Begin + Indices, TupleType>>>>::bIntegers || ...);
+		constexpr std::size_t Size = (sizeof(std::get<Begin + Indices>(Fields)) + ...);
+
+		if (bIntegers && Stream.GetIntEncoding() != EIntEncoding::Fixed)
+		{
+			(Stream & ... & std::get<Begin + Indices>(Fields));
+			return;
+		}
+
+		char Block[Size];
+		std::size_t Offset = 0;
+
+		if constexpr (IsOutStream<StreamType>)
+		{
+			((std::memcpy(Block + Offset, &std::get<Begin + Indices>(Fields), sizeof(std::get<Begin + Indices>(Fields))),
+				Offset += sizeof(std::get<Begin + Indices>(Fields))), ...);
+			Stream.Push(Block, Size);
+		}
+		else
+		{
+			Stream.Pop(Block, Size);
+			if (!Stream.IsValidInput())
+				return;
+
+			((std::memcpy(&std::get<Begin + Indices>(Fields), Block + Offset, sizeof(std::get<Begin + Indices>(Fields))),
+				Offset += sizeof(std::get<Begin + Indices>(Fields))), ...);
+		}
+	}
+
+	template<std::size_t Index, typename StreamType, typename TupleType>
+	void StreamFieldsFrom(StreamType& Stream, TupleType& Fields)
+	{
+		constexpr std::size_t Num = std::tuple_size_v<TupleType>;
+
+		if constexpr (Index < Num)
+		{
+			constexpr std::size_t End = FusedRunEnd<TupleType>(Index, std::make_index_sequence<Num>{});
+
+			if constexpr (End - Index >= 2)
+			{
+				StreamFusedRun<Index>(Stream, Fields, std::make_index_sequence<End - Index>{});
+				StreamFieldsFrom<End>(Stream, Fields);
+			}
+			else
+			{
+				Stream & std::forward<std::tuple_element_t<Index, TupleType>>(std::get<Index>(Fields));
+				StreamFieldsFrom<Index + 1>(Stream, Fields);
+			}
+		}
+	}
+
+	template<typename StreamType, typename TupleType>
+	void StreamFields(StreamType& Stream, TupleType&& Fields)
+	{
+		StreamFieldsFrom<0>(Stream, Fields);
+	}
+
+	template<typename StreamType, typename T, std::enable_if_t<IsOutStream<StreamType>>* = nullptr>
 	StreamType& operator& (StreamType& Stream, const T& Data)
 	{
 		using namespace TK;
@@ -61,7 +581,7 @@ namespace TK
 		return Stream;
 	}
 
-	template<typename StreamType, typename T, std::enable_if_t<std::is_base_of_v<FInStream, StreamType>>* = nullptr>
+	template<typename StreamType, typename T, std::enable_if_t<IsInStream<StreamType>>* = nullptr>
 	StreamType& operator& (StreamType& Stream, T& Data)
 	{
 		using namespace TK;
@@ -69,6 +589,14 @@ namespace TK
 		return Stream;
 	}
 
+	template<typename StreamType, typename T, std::enable_if_t<IsInStream<StreamType> && IsSerialProxy<T>>* = nullptr>
+	StreamType& operator& (StreamType& Stream, T&& Data)
+	{
+		using namespace TK;
+		Load(Stream, Data);
+		return Stream;
+	}
+
 	template<typename SizeType>
 	bool IsSizeOverflow(SizeType Size)
 	{
@@ -76,20 +604,113 @@ namespace TK
 		return static_cast<std::uint64_t>(Size) > static_cast<std::uint64_t>(MaxAllowed);
 	}
 
-	inline void Save(FOutStream& Stream, const bool& Data)
+	template<typename StreamType, std::enable_if_t<IsOutStream<StreamType>>* = nullptr>
+	void Save(StreamType& Stream, const bool& Data)
+	{
+		if constexpr (IsBitStream<StreamType>)
+		{
+			Stream.WriteBits(Data ? 1 : 0, 1);
+		}
+		else
+		{
+			Stream.template PushAs<std::uint8_t>(Data);
+		}
+	}
+
+	template<typename StreamType, std::enable_if_t<IsInStream<StreamType>>* = nullptr>
+	void Load(StreamType& Stream, bool& Data)
 	{
-		Stream.PushAs<std::uint8_t>(Data);
+		if constexpr (IsBitStream<StreamType>)
+		{
+			std::uint64_t Bit = Stream.ReadBits(1);
+			if (Stream.IsValidInput())
+				Data = Bit != 0;
+		}
+		else
+		{
+			Stream.template PopAs<std::uint8_t>(Data);
+		}
 	}
 
-	inline void Load(FInStream& Stream, bool& Data)
+	template<typename StreamType, typename T, auto Min, auto Max, std::enable_if_t<IsOutStream<StreamType>>* = nullptr>
+	void Save(StreamType& Stream, const TRangedRef<T, Min, Max>& Data)
 	{
-		Stream.PopAs<std::uint8_t>(Data);
+		using RangedType = TRangedRef<T, Min, Max>;
+
+		if (!RangedType::InRange(Data.Value))
+		{
+			Stream.MarkOutputInvalid();
+			TK_ASSERT(false);
+			return;
+		}
+
+		if constexpr (IsBitStream<StreamType>)
+		{
+			Stream.WriteBits(RangedType::ToBits(Data.Value) - RangedType::ToBits(Min), RangedType::Bits);
+		}
+		else
+		{
+			Save(Stream, Data.Value);
+		}
 	}
 
-	template<typename T, int N>
-	void Save(FOutStream& Stream, const T(&Data)[N])
+	template<typename StreamType, typename T, auto Min, auto Max, std::enable_if_t<IsInStream<StreamType>>* = nullptr>
+	void Load(StreamType& Stream, const TRangedRef<T, Min, Max>& Data)
 	{
-		if constexpr (IsBitwisePackable<T>)
+		using RangedType = TRangedRef<T, Min, Max>;
+		typename RangedType::ValueType Value {};
+
+		if constexpr (IsBitStream<StreamType>)
+		{
+			std::uint64_t Offset = Stream.ReadBits(RangedType::Bits);
+			if (Offset > RangedType::Span)
+			{
+				Stream.MarkInputInvalid();
+				return;
+			}
+
+			Value = RangedType::FromBits(RangedType::ToBits(Min) + Offset);
+		}
+		else
+		{
+			Load(Stream, Value);
+		}
+
+		if (!Stream.IsValidInput())
+			return;
+
+		if (!RangedType::InRange(Value))
+		{
+			Stream.MarkInputInvalid();
+			return;
+		}
+
+		Data.Value = Value;
+	}
+
+	// enums go through their underlying type, so they follow the stream's integer encoding.
+	template<typename StreamType, typename T,
+		std::enable_if_t<IsOutStream<StreamType> && std::is_enum_v<T>>* = nullptr>
+	void Save(StreamType& Stream, const T& Data)
+	{
+		Save(Stream, static_cast<std::underlying_type_t<T>>(Data));
+	}
+
+	template<typename StreamType, typename T,
+		std::enable_if_t<IsInStream<StreamType> && std::is_enum_v<T>>* = nullptr>
+	void Load(StreamType& Stream, T& Data)
+	{
+		std::underlying_type_t<T> Value {};
+		Load(Stream, Value);
+
+		if (Stream.IsValidInput())
+			Data = static_cast<T>(Value);
+	}
+
+	template<typename StreamType, typename T, int N, std::enable_if_t<IsOutStream<StreamType>>* = nullptr>
+	void Save(StreamType& Stream, const T(&Data)[N])
+	{
+		if (IsRawEncoded<T>(Stream))
 		{
 			Stream.Push(Data, sizeof(T) * N);
 		}
@@ -102,10 +723,10 @@ namespace TK
 		}
 	}
 
-	template<typename T, int N>
-	void Load(FInStream& Stream, T(&Data)[N])
+	template<typename StreamType, typename T, int N, std::enable_if_t<IsInStream<StreamType>>* = nullptr>
+	void Load(StreamType& Stream, T(&Data)[N])
 	{
-		if constexpr (IsBitwisePackable<T>)
+		if (IsRawEncoded<T>(Stream))
 		{
 			Stream.Pop(Data, sizeof(T) * N);
 		}
@@ -118,10 +739,10 @@ namespace TK
 		}
 	}
 
-	template<typename T, std::size_t N>
-	void Save(FOutStream& Stream, const std::array<T, N>& Data)
+	template<typename StreamType, typename T, std::size_t N, std::enable_if_t<IsOutStream<StreamType>>* = nullptr>
+	void Save(StreamType& Stream, const std::array<T, N>& Data)
 	{
-		if constexpr (IsBitwisePackable<T>)
+		if (IsRawEncoded<T>(Stream))
 		{
 			Stream.Push(Data.data(), sizeof(T) * N);
 		}
@@ -134,10 +755,10 @@ namespace TK
 		}
 	}
 
-	template<typename T, std::size_t N>
-	void Load(FInStream& Stream, std::array<T, N>& Data)
+	template<typename StreamType, typename T, std::size_t N, std::enable_if_t<IsInStream<StreamType>>* = nullptr>
+	void Load(StreamType& Stream, std::array<T, N>& Data)
 	{
-		if constexpr (IsBitwisePackable<T>)
+		if (IsRawEncoded<T>(Stream))
 		{
 			Stream.Pop(Data.data(), sizeof(T) * N);
 		}
@@ -150,8 +771,8 @@ namespace TK
 		}
 	}
 	
-	template<typename T, typename SizeType>
-    void Save(FOutStream& Stream, const T* Data, SizeType Num)
+	template<typename StreamType, typename T, typename SizeType, std::enable_if_t<IsOutStream<StreamType>>* = nullptr>
+    void Save(StreamType& Stream, const T* Data, SizeType Num)
     {
 		if (Num < 0)
 			return;
@@ -163,8 +784,8 @@ namespace TK
 			return;
 		}
 
-		Stream.PushAs<std::uint32_t>(Num);
-		if constexpr (IsBitwisePackable<T>)
+		SaveSize(Stream, Num);
+		if (IsRawEncoded<T>(Stream))
 		{
 			Stream.Push(Data, Num * sizeof(T));
 		}
@@ -177,25 +798,27 @@ namespace TK
 		}
     }
 
-	template<typename CharType>
-	void Save(FOutStream& Stream, const std::basic_string_view<CharType>& Data)
+	template<typename StreamType, typename CharType, std::enable_if_t<IsOutStream<StreamType>>* = nullptr>
+	void Save(StreamType& Stream, const std::basic_string_view<CharType>& Data)
 	{
 		Save(Stream, Data.data(), Data.size());
 	}
 
-	template<typename CharType>
-	void Save(FOutStream& Stream, const std::basic_string<CharType>& Data)
+	template<typename StreamType, typename CharType, typename TraitsType, typename AllocatorType,
+		std::enable_if_t<IsOutStream<StreamType>>* = nullptr>
+	void Save(StreamType& Stream, const std::basic_string<CharType, TraitsType, AllocatorType>& Data)
 	{
 		Save(Stream, Data.data(), Data.size());
 	}
 
-	template<typename CharType>
-	void Load(FInStream& Stream, std::basic_string<CharType>& Data)
+	template<typename StreamType, typename CharType, typename TraitsType, typename AllocatorType,
+		std::enable_if_t<IsInStream<StreamType>>* = nullptr>
+	void Load(StreamType& Stream, std::basic_string<CharType, TraitsType, AllocatorType>& Data)
 	{
 		if (!Stream.IsValidInput())
 			return;
 
-		std::uint32_t CharsNum = Stream.Pop<std::uint32_t>();
+		std::uint32_t CharsNum = LoadSize(Stream);
 		if (!Stream.EnsureEnoughBytes(CharsNum * sizeof(CharType)))
 		{
 			Stream.MarkInputInvalid();
@@ -203,46 +826,119 @@ namespace TK
 			return;
 		}
 
-		Data.resize(CharsNum);
-		Stream.Pop(Data.data(), CharsNum * sizeof(CharType));
+		if constexpr (IsMemReader<StreamType>)
+		{
+			Data.clear();
+			Data.append(static_cast<const CharType*>(Stream.GetReadPos()), CharsNum);
+			Stream.Advance(CharsNum * sizeof(CharType));
+		}
+		else
+		{
+			Data.resize(CharsNum);
+			Stream.Pop(Data.data(), CharsNum * sizeof(CharType));
+		}
 	}
 
-	template<typename CharType>
-	void Load(FMemReader& Stream, std::basic_string<CharType>& Data)
+	// views share the wire format of strings and vectors but never copy on load. the stream must
+	// be an FMemReader and the elements raw encoded. TArrayView copies each element out as bytes,
+	// so its alignment inside the buffer does not matter. a string_view hands its pointer to the
+	// standard library, wide characters that are not aligned for CharType fail the load.
+	template<typename T, typename StreamType>
+	const void* LoadView(StreamType& Stream, std::uint32_t& Num)
 	{
+		static_assert(IsMemReader<StreamType>, "views can only be loaded from an FMemReader.");
+		static_assert(IsBitwisePackable<T> && !std::is_same_v<T, bool>, "views need bitwise packable elements.");
+
+		Num = 0;
 		if (!Stream.IsValidInput())
-			return;
+			return nullptr;
 
-		std::uint32_t CharsNum = Stream.Pop<std::uint32_t>();
-		if (!Stream.EnsureEnoughBytes(CharsNum * sizeof(CharType)))
+		std::uint32_t Count = LoadSize(Stream);
+		if (!IsRawEncoded<T>(Stream) || !Stream.EnsureEnoughBytes(Count * sizeof(T)))
 		{
 			Stream.MarkInputInvalid();
 			TK_ASSERT(false);
+			return nullptr;
+		}
+
+		const void* Start = Stream.GetReadPos();
+		Stream.Advance(Count * sizeof(T));
+
+		Num = Count;
+		return Start;
+	}
+
+	template<typename StreamType, typename CharType, std::enable_if_t<IsMemReader<StreamType>>* = nullptr>
+	void Load(StreamType& Stream, std::basic_string_view<CharType>& Data)
+	{
+		std::uint32_t Num = 0;
+		const void* Start = LoadView<CharType>(Stream, Num);
+		if (!Stream.IsValidInput())
 			return;
+
+		if constexpr (alignof(CharType) > 1)
+		{
+			if (reinterpret_cast<std::uintptr_t>(Start) % alignof(CharType) != 0)
+			{
+				Stream.MarkInputInvalid();
+				return;
+			}
 		}
 
-		Data.clear();
-		Data.append(static_cast<const CharType*>(Stream.GetReadPos()), CharsNum);
-		Stream.Advance(CharsNum * sizeof(CharType));
+		Data = std::basic_string_view<CharType>(static_cast<const CharType*>(Start), Num);
 	}
 
-	template<typename T>
-	void Save(FOutStream& Stream, const std::vector<T>& Data)
+	template<typename StreamType, typename T, std::enable_if_t<IsOutStream<StreamType>>* = nullptr>
+	void Save(StreamType& Stream, const TArrayView<T>& Data)
 	{
-		Save<T, typename std::vector<T>::size_type>(Stream, Data.data(), Data.size());		
+		if (IsSizeOverflow(Data.GetSize()))
+		{
+			Stream.MarkOutputInvalid();
+			TK_ASSERT(false);
+			return;
+		}
+
+		SaveSize(Stream, Data.GetSize());
+		if (IsRawEncoded<T>(Stream))
+		{
+			Stream.Push(Data.GetData(), Data.GetSize() * sizeof(T));
+		}
+		else
+		{
+			for (T Item : Data)
+			{
+				Save(Stream, Item);
+			}
+		}
 	}
 
-	template<typename T>
-	void Load(FInStream& Stream, std::vector<T>& Data)
+	template<typename StreamType, typename T, std::enable_if_t<IsMemReader<StreamType>>* = nullptr>
+	void Load(StreamType& Stream, TArrayView<T>& Data)
+	{
+		std::uint32_t Num = 0;
+		const void* Start = LoadView<T>(Stream, Num);
+
+		if (Stream.IsValidInput())
+			Data = TArrayView<T>::FromBytes(Start, Num);
+	}
+
+	template<typename StreamType, typename T, typename AllocatorType, std::enable_if_t<IsOutStream<StreamType>>* = nullptr>
+	void Save(StreamType& Stream, const std::vector<T, AllocatorType>& Data)
+	{
+		Save(Stream, Data.data(), Data.size());		
+	}
+
+	template<typename StreamType, typename T, typename AllocatorType, std::enable_if_t<IsInStream<StreamType>>* = nullptr>
+	void Load(StreamType& Stream, std::vector<T, AllocatorType>& Data)
 	{
 		if (!Stream.IsValidInput())
 			return;
 
-		std::uint32_t Num = Stream.Pop<std::uint32_t>();
-		Data.clear();
+		std::uint32_t Num = LoadSize(Stream);
 
-		if constexpr (IsBitwisePackable<T>)
+		if (IsRawEncoded<T>(Stream))
 		{
+			Data.clear();
 			if (!Stream.EnsureEnoughBytes(Num * sizeof(T)))
 			{
 				Stream.MarkInputInvalid();
@@ -250,73 +946,140 @@ namespace TK
 				return;
 			}
 
+			// the read position can be misaligned for T, so it is only ever copied as bytes
 			Data.resize(Num);
-			Stream.Pop(Data.data(), Num * sizeof(T));
+			if constexpr (IsMemReader<StreamType>)
+			{
+				if (Num > 0)
+					std::memcpy(static_cast<void*>(Data.data()), Stream.GetReadPos(), Num * sizeof(T));
+				Stream.Advance(Num * sizeof(T));
+			}
+			else
+			{
+				Stream.Pop(Data.data(), Num * sizeof(T));
+			}
+		}
+		else if (Stream.IsReusingContainers())
+		{
+			// grows one element at a time like the loop below, a bogus count cannot allocate ahead
+			std::uint32_t Loaded = 0;
+			for (; Loaded < Num; ++Loaded)
+			{
+				if (Loaded == Data.size())
+					Data.emplace_back();
+
+				Load(Stream, Data[Loaded]);
+				if (!Stream.IsValidInput())
+					break;
+			}
+
+			Data.erase(Data.begin() + Loaded, Data.end());
 		}
 		else
 		{
+			// elements are built in place, so allocator aware ones get the vector's allocator
+			Data.clear();
 			for (std::uint32_t i = 0; i < Num; ++i)
 			{
-				T Item {};
-				Load(Stream, Item);
+				Load(Stream, Data.emplace_back());
 
-				if (Stream.IsValidInput())
-				{
-					Data.push_back(Item);
-				}
-				else
+				if (!Stream.IsValidInput())
 				{
+					Data.pop_back();
 					break;
 				}
 			}
 		}
 	}
 
-	template<typename T>
-	void Load(FMemReader& Stream, std::vector<T>& Data)
+	// one bit per element on bit streams, packed eight per byte elsewhere.
+	template<typename StreamType, typename AllocatorType, std::enable_if_t<IsOutStream<StreamType>>* = nullptr>
+	void Save(StreamType& Stream, const std::vector<bool, AllocatorType>& Data)
 	{
-		if (!Stream.IsValidInput())
+		if (IsSizeOverflow(Data.size()))
+		{
+			Stream.MarkOutputInvalid();
+			TK_ASSERT(false);
 			return;
+		}
 
-		std::uint32_t Num = Stream.Pop<std::uint32_t>();
-		Data.clear();
+		SaveSize(Stream, Data.size());
 
-		if constexpr (IsBitwisePackable<T>)
+		std::uint64_t Word = 0;
+		int WordBits = 0;
+		for (bool bValue : Data)
 		{
-			if (!Stream.EnsureEnoughBytes(Num * sizeof(T)))
+			Word |= std::uint64_t(bValue ? 1 : 0) << WordBits;
+			if (++WordBits == 64)
 			{
-				Stream.MarkInputInvalid();
-				TK_ASSERT(false);
-				return;
+				if constexpr (IsBitStream<StreamType>)
+				{
+					Stream.WriteBits(Word, 64);
+				}
+				else
+				{
+					Stream.Push(&Word, sizeof(Word));
+				}
+
+				Word = 0;
+				WordBits = 0;
 			}
+		}
 
-			const T* Start = static_cast<const T*>(Stream.GetReadPos());
-			const T* End = Start + Num;
-			
-			Data.insert(Data.end(), Start, End);
-			Stream.Advance(Num * sizeof(T));
+		if constexpr (IsBitStream<StreamType>)
+		{
+			Stream.WriteBits(Word, WordBits);
 		}
 		else
 		{
-			for (std::uint32_t i = 0; i < Num; ++i)
+			Stream.Push(&Word, (WordBits + 7) / 8);
+		}
+	}
+
+	template<typename StreamType, typename AllocatorType, std::enable_if_t<IsInStream<StreamType>>* = nullptr>
+	void Load(StreamType& Stream, std::vector<bool, AllocatorType>& Data)
+	{
+		if (!Stream.IsValidInput())
+			return;
+
+		std::uint32_t Num = LoadSize(Stream);
+		Data.clear();
+
+		if (!Stream.EnsureEnoughBytes((static_cast<std::uint64_t>(Num) + 7) / 8))
+		{
+			Stream.MarkInputInvalid();
+			TK_ASSERT(false);
+			return;
+		}
+
+		Data.resize(Num);
+		for (std::uint32_t Index = 0; Index < Num; Index += 64)
+		{
+			int WordBits = Num - Index < 64 ? static_cast<int>(Num - Index) : 64;
+			std::uint64_t Word = 0;
+
+			if constexpr (IsBitStream<StreamType>)
+			{
+				Word = Stream.ReadBits(WordBits);
+			}
+			else
 			{
-				T Item {};
-				Load(Stream, Item);
+				Stream.Pop(&Word, (WordBits + 7) / 8);
+			}
 
-				if (Stream.IsValidInput())
-				{
-					Data.push_back(Item);
-				}
-				else
-				{
-					return;
-				}
+			if (!Stream.IsValidInput())
+				return;
+
+			for (int Bit = 0; Bit < WordBits; ++Bit)
+			{
+				Data[Index + Bit] = (Word >> Bit) & 1;
 			}
 		}
 	}
 
-	template<typename K, typename V>
-	void Save(FOutStream& Stream, const std::map<K, V>& Data)
+	template<typename StreamType, typename K, typename V, typename CompareType, typename AllocatorType,
+		std::enable_if_t<IsOutStream<StreamType>>* = nullptr>
+	void Save(StreamType& Stream, const std::map<K, V, CompareType, AllocatorType>& Data)
 	{
 		if (IsSizeOverflow(Data.size()))
 		{
@@ -325,7 +1088,7 @@ namespace TK
 			return;
 		}
 
-		Stream.PushAs<std::uint32_t>(Data.size());
+		SaveSize(Stream, Data.size());
 		for (const auto& Pair : Data)
 		{
 			Save(Stream, Pair.first);
@@ -333,19 +1096,77 @@ namespace TK
 		}
 	}
 
-	template<typename K, typename V>
-	void Load(FInStream& Stream, std::map<K, V>& Data)
+	// old nodes are extracted front to back and loaded over, keys and values keep their buffers.
+	// entries come sorted from Save, so every insert lands at the end.
+	template<typename StreamType, typename MapType>
+	void LoadReusingNodes(StreamType& Stream, MapType& Data, std::uint32_t Num)
+	{
+		using K = typename MapType::key_type;
+		using V = typename MapType::mapped_type;
+
+		MapType Loaded(Data.key_comp(), Data.get_allocator());
+		for (std::uint32_t i = 0; i < Num; ++i)
+		{
+			if (Data.empty())
+			{
+				K Key = MakeWithAllocator<K>(Data.get_allocator());
+				V Value = MakeWithAllocator<V>(Data.get_allocator());
+
+				Load(Stream, Key);
+				Load(Stream, Value);
+
+				if (!Stream.IsValidInput())
+					break;
+
+				std::size_t Size = Loaded.size();
+				Loaded.emplace_hint(Loaded.end(), std::move(Key), std::move(Value));
+
+				if (Loaded.size() == Size)
+				{
+					Stream.MarkInputInvalid();
+					break;
+				}
+			}
+			else
+			{
+				auto Node = Data.extract(Data.begin());
+				Load(Stream, Node.key());
+				Load(Stream, Node.mapped());
+
+				if (!Stream.IsValidInput())
+					break;
+
+				Loaded.insert(Loaded.end(), std::move(Node));
+				if (!Node.empty())
+				{
+					Stream.MarkInputInvalid();
+					break;
+				}
+			}
+		}
+
+		Data.swap(Loaded);
+	}
+
+	template<typename StreamType, typename K, typename V, typename CompareType, typename AllocatorType,
+		std::enable_if_t<IsInStream<StreamType>>* = nullptr>
+	void Load(StreamType& Stream, std::map<K, V, CompareType, AllocatorType>& Data)
 	{
 		if (!Stream.IsValidInput())
 			return;
 
-		Data.clear();
+		std::uint32_t Num = LoadSize(Stream);
+		if (Stream.IsReusingContainers())
+		{
+			LoadReusingNodes(Stream, Data, Num);
+			return;
+		}
 
-		std::uint32_t Num = Stream.Pop<std::uint32_t>();
+		Data.clear();
 		for (std::uint32_t i = 0; i < Num; ++i)
 		{
-			K Key {};
-			V Value {};
+			K Key = MakeWithAllocator<K>(Data.get_allocator());
+			V Value = MakeWithAllocator<V>(Data.get_allocator());
 
 			Load(Stream, Key);
 			Load(Stream, Value);
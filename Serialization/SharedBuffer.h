@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include "Serialization/MemoryWriter.h"
+
+namespace TK
+{
+	// immutable bytes shared by any number of owners through an atomic reference count, so one
+	// encoded message can sit in many send queues at once. copying it never copies the bytes.
+	class FSharedBuffer
+	{
+	public:
+
+		FSharedBuffer() = default;
+
+		// Data and Size point into what Owner keeps alive.
+		template<typename OwnerType>
+		FSharedBuffer(const std::shared_ptr<OwnerType>& Owner, const char* InData, std::size_t InSize) :
+			Data(Owner, InData), Size(InSize) {}
+
+		const char* GetData() const { return Data.get(); }
+
+		std::size_t GetSize() const { return Size; }
+
+		bool IsEmpty() const { return Size == 0; }
+
+		// number of FSharedBuffer sharing these bytes, 0 when empty.
+		long GetUseCount() const { return Data.use_count(); }
+
+		void Reset()
+		{
+			Data.reset();
+			Size = 0;
+		}
+
+	private:
+
+		std::shared_ptr<const char> Data;
+		std::size_t Size {0};
+	};
+
+	// takes the writer's storage into an FSharedBuffer, a heap buffer is moved rather than copied
+	// and inline bytes go along with the reference count in one allocation. the writer is left
+	// empty, and an invalid or empty writer gives an empty buffer.
+	template<int N, typename AllocatorType>
+	FSharedBuffer Freeze(TMemWriter<N, AllocatorType>& Writer)
+	{
+		using StorageType = typename TMemWriter<N, AllocatorType>::StorageType;
+
+		if (!Writer.IsValidOutput() || Writer.GetSize() == 0)
+		{
+			Writer.Clear();
+			return FSharedBuffer();
+		}
+
+		auto Owner = std::make_shared<StorageType>(Writer.TakeStorage());
+
+		if constexpr (N == 0)
+		{
+			return FSharedBuffer(Owner, Owner->data(), Owner->size());
+		}
+		else
+		{
+			if (Owner->index() == 0)
+			{
+				const auto& Inline = std::get<0>(*Owner);
+				return FSharedBuffer(Owner, Inline.Data.data(), static_cast<std::size_t>(Inline.Size));
+			}
+
+			const auto& Heap = std::get<1>(*Owner);
+			return FSharedBuffer(Owner, Heap.data(), Heap.size());
+		}
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include "Serialization/OutStream.h"
+#include "Serialization/SerializeFuncs.h"
+
+namespace TK
+{
+	// writes nothing and only counts, so a dry run tells the exact size a writer will need.
+	//
+	//     TK::FSizeCounter Counter;
+	//     Counter & Data;
+	//     Writer.Reserve(Counter.GetSize());
+	//
+	// set the same integer encoding as the real writer, sizes differ between modes.
+	class FSizeCounter : public TOutStream<FSizeCounter>
+	{
+		friend class TOutStream<FSizeCounter>;
+
+	public:
+
+		std::size_t GetSize() const { return Size; }
+
+		void Clear()
+		{
+			bValidOutput = true;
+			Size = 0;
+		}
+
+		// length slots are counted at the size a TMemWriter ends up with, their varints compacted.
+		// a TSegmentedWriter keeps them padded and can come out larger.
+		void Overwrite(std::size_t, const void*, std::size_t) {}
+
+		void ShrinkTo(std::size_t TargetSize)
+		{
+			if (TargetSize < Size)
+				Size = TargetSize;
+		}
+
+	protected:
+
+		bool PushBytes(const void*, SizeType Length)
+		{
+			if (Length > 0)
+				Size += static_cast<std::size_t>(Length);
+			return true;
+		}
+
+		std::size_t Size {0};
+	};
+
+	// bytes Args take when saved in order in fixed int encoding.
+	template<typename ...ArgTypes>
+	std::size_t MeasureSize(const ArgTypes&... Args)
+	{
+		FSizeCounter Counter;
+		(Counter & ... & Args);
+		return Counter.GetSize();
+	}
+}
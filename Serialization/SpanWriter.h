@@ -0,0 +1,121 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include "Serialization/OutStream.h"
+#include "TinkerAssert.h"
+
+namespace TK
+{
+	// writes into a fixed region owned by someone else, such as a slot of a send ring or a page of
+	// shared memory, so the encoded bytes need no second copy. a push that does not fit is not
+	// written at all and turns the output invalid, the region is never grown.
+	//
+	//     TK::FSpanWriter Writer(Ring.AcquireSlot(), Ring.GetSlotSize());
+	//     char* Head = Writer.ReserveBytes(sizeof(FHeader));
+	//     Writer & Payload;
+	//     if (Writer.IsValidOutput())
+	//         Ring.Commit(Writer.GetSize());
+	class FSpanWriter : public TOutStream<FSpanWriter>
+	{
+		friend class TOutStream<FSpanWriter>;
+
+	public:
+
+		FSpanWriter() = default;
+
+		template<typename InSizeType>
+		FSpanWriter(void* Dest, InSizeType Capacity)
+		{
+			Init(Dest, Capacity);
+		}
+
+		// points the writer at a new region, the integer encoding is kept.
+		template<typename InSizeType>
+		void Init(void* Dest, InSizeType Capacity)
+		{
+			TK_ASSERT(Capacity >= 0);
+
+			Begin = static_cast<char*>(Dest);
+			Cursor = Begin;
+			End = Begin + Capacity;
+			Pinned = Begin;
+			bValidOutput = true;
+		}
+
+		std::size_t GetSize() const { return static_cast<std::size_t>(Cursor - Begin); }
+
+		std::size_t GetCapacity() const { return static_cast<std::size_t>(End - Begin); }
+
+		std::size_t GetAvailableSpace() const { return static_cast<std::size_t>(End - Cursor); }
+
+		const char* GetBuffer() const { return Begin; }
+
+		char* GetBuffer() { return Begin; }
+
+		void Clear()
+		{
+			Cursor = Begin;
+			Pinned = Begin;
+			bValidOutput = true;
+		}
+
+		// keeps only the first TargetSize bytes, no effect if there are not more than that.
+		void ShrinkTo(std::size_t TargetSize)
+		{
+			if (TargetSize < GetSize())
+				Cursor = Begin + TargetSize;
+			if (Pinned > Cursor)
+				Pinned = Cursor;
+		}
+
+		void Overwrite(std::size_t Offset, const void* Source, std::size_t Length)
+		{
+			TK_ASSERT(Offset <= GetSize() && Length <= GetSize() - Offset);
+			std::memcpy(Begin + Offset, Source, Length);
+		}
+
+		// hands out the next Length bytes for the caller to fill in place, as if they were pushed.
+		// nullptr when they do not fit, which turns the output invalid. the pointer is good until
+		// Clear(), Init() or ShrinkTo() drop those bytes, length slots around it are padded
+		// instead of compacted so they never move it.
+		char* ReserveBytes(SizeType Length)
+		{
+			if (!bValidOutput)
+				return nullptr;
+
+			if (Length < 0 || Length > End - Cursor)
+			{
+				bValidOutput = false;
+				return nullptr;
+			}
+
+			char* Reserved = Cursor;
+			Cursor += Length;
+			Pinned = Cursor;
+			return Reserved;
+		}
+
+		// end of the last bytes handed out by ReserveBytes, nothing before it may move.
+		std::size_t GetPinnedSize() const { return static_cast<std::size_t>(Pinned - Begin); }
+
+	protected:
+
+		bool PushBytes(const void* Source, SizeType Length)
+		{
+			if (Length <= 0)
+				return true;
+
+			if (Length > End - Cursor)
+				return false;
+
+			std::memcpy(Cursor, Source, static_cast<std::size_t>(Length));
+			Cursor += Length;
+			return true;
+		}
+
+		char* Begin {nullptr};
+		char* Cursor {nullptr};
+		char* End {nullptr};
+		char* Pinned {nullptr};
+	};
+}
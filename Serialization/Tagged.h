@@ -0,0 +1,260 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "Serialization/LengthSlot.h"
+#include "Serialization/LimitedReader.h"
+#include "Serialization/SerializeFuncs.h"
+
+namespace TK
+{
+	// how a tagged field is laid out on the wire. fixed widths are skipped by their size, the
+	// rest carry a varint length.
+	enum class ETagWire : std::uint8_t
+	{
+		Fixed1,
+		Fixed2,
+		Fixed4,
+		Fixed8,
+		Bytes,
+	};
+
+	constexpr int TagWireBits = 3;
+
+	constexpr std::uint32_t MakeTagKey(std::uint32_t Id, ETagWire Wire)
+	{
+		return Id << TagWireBits | static_cast<std::uint32_t>(Wire);
+	}
+
+	constexpr std::uint32_t TagWireSize(ETagWire Wire)
+	{
+		return Wire == ETagWire::Bytes ? 0 : 1u << static_cast<std::uint32_t>(Wire);
+	}
+
+	template<typename T, typename StreamType>
+	ETagWire GetTagWire(const StreamType& Stream)
+	{
+		constexpr std::size_t Size = FixedEncodedSize<T>;
+
+		if (TFixedSize<T>::bIntegers && Stream.GetIntEncoding() != EIntEncoding::Fixed)
+			return ETagWire::Bytes;
+
+		switch (Size)
+		{
+		case 1: return ETagWire::Fixed1;
+		case 2: return ETagWire::Fixed2;
+		case 4: return ETagWire::Fixed4;
+		case 8: return ETagWire::Fixed8;
+		default: return ETagWire::Bytes;
+		}
+	}
+
+	// FNV-1a over the field list with blanks dropped, mixed with each field's fixed size, so
+	// renaming, reordering or resizing a field changes it.
+	template<typename TupleType, std::size_t... Indices>
+	constexpr std::uint32_t HashTaggedSchema(std::string_view Names, std::index_sequence<Indices...>)
+	{
+		std::uint32_t Hash = 2166136261u;
+		for (char Char : Names)
+		{
+			if (Char != ' ')
+				Hash = (Hash ^ static_cast<std::uint8_t>(Char)) * 16777619u;
+		}
+
+		using FieldTypes = std::tuple<std::remove_cv_t<std::remove_reference_t<std::tuple_element_t<Indices, TupleType>>>...>;
+		constexpr std::uint32_t Sizes[] = { 0u, (static_cast<std::uint32_t>(TFixedSize<std::tuple_element_t<Indices, FieldTypes>>::Size) << 1 |
+			(TFixedSize<std::tuple_element_t<Indices, FieldTypes>>::bIntegers ? 1u : 0u))... };
+
+		for (std::uint32_t Size : Sizes)
+		{
+			for (int Shift = 0; Shift < 32; Shift += 8)
+			{
+				Hash = (Hash ^ ((Size >> Shift) & 0xFF)) * 16777619u;
+			}
+		}
+		return Hash;
+	}
+
+	template<typename TupleType>
+	constexpr std::uint32_t HashTaggedSchema(std::string_view Names)
+	{
+		return HashTaggedSchema<TupleType>(Names, std::make_index_sequence<std::tuple_size_v<TupleType>>{});
+	}
+
+	template<typename StreamType, typename FieldType>
+	void SaveTaggedField(StreamType& Stream, std::uint32_t Id, const FieldType& Field)
+	{
+		using ValueType = std::remove_cv_t<FieldType>;
+
+		ETagWire Wire = GetTagWire<ValueType>(Stream);
+		SaveVarint(Stream, MakeTagKey(Id, Wire));
+
+		if (Wire == ETagWire::Bytes)
+		{
+			SaveSizePrefixed(Stream, Field, GetSizeSlot(Stream));
+		}
+		else
+		{
+			Stream & Field;
+		}
+	}
+
+	// same schema, fields come in order and decode in place. the keys are still checked so a
+	// hash collision fails instead of misreading.
+	template<typename StreamType, typename FieldType>
+	void LoadTaggedFieldInOrder(StreamType& Stream, std::uint32_t Id, FieldType& Field)
+	{
+		using ValueType = std::remove_cv_t<FieldType>;
+
+		if (!Stream.IsValidInput())
+			return;
+
+		ETagWire Wire = GetTagWire<ValueType>(Stream);
+		std::uint32_t Key = 0;
+		LoadVarint(Stream, Key);
+
+		if (Key != MakeTagKey(Id, Wire))
+		{
+			Stream.MarkInputInvalid();
+			return;
+		}
+
+		if (Wire == ETagWire::Bytes)
+		{
+			// the length still bounds the field, a mismatch fails instead of eating the next one
+			std::uint32_t Length = LoadSize(Stream);
+			LoadBounded(Stream, Field, Length);
+			return;
+		}
+
+		Stream & Field;
+	}
+
+	// false when the writer's wire type differs, the field is then skipped and keeps its value.
+	template<typename StreamType, typename FieldType>
+	bool LoadTaggedValue(StreamType& Stream, FieldType& Field, ETagWire Wire, std::uint32_t Length)
+	{
+		using ValueType = std::remove_cv_t<FieldType>;
+
+		if (Wire != GetTagWire<ValueType>(Stream))
+			return false;
+
+		if (Wire != ETagWire::Bytes)
+		{
+			Stream & Field;
+			return true;
+		}
+
+		LoadBounded(Stream, Field, Length);
+		return true;
+	}
+
+	template<typename StreamType, typename TupleType, std::size_t... Indices>
+	bool LoadTaggedById(StreamType& Stream, TupleType& Fields, std::uint32_t Id, ETagWire Wire, std::uint32_t Length,
+		std::index_sequence<Indices...>)
+	{
+		bool bLoaded = false;
+		((Id == Indices + 1 && (bLoaded = LoadTaggedValue(Stream, std::get<Indices>(Fields), Wire, Length), true)) || ...);
+		return bLoaded;
+	}
+
+	// object header is the uint32 schema hash and a varint field count, then every field as a
+	// varint key (id << 3 | wire), a size prefix for ETagWire::Bytes in the stream's integer
+	// encoding, and its usual encoding.
+	// ids are the 1 based positions in TK_SERIAL_TAGGED, so new fields go at the end.
+	template<typename StreamType, typename TupleType>
+	void SaveTagged(StreamType& Stream, const TupleType& Fields, std::uint32_t SchemaHash)
+	{
+		static_assert(!IsBitStream<StreamType>, "tagged types need a byte stream.");
+
+		Stream.template PushAs<std::uint32_t>(SchemaHash);
+		SaveVarint(Stream, static_cast<std::uint32_t>(std::tuple_size_v<TupleType>));
+
+		std::apply([&](const auto&... Field)
+		{
+			std::uint32_t Id = 0;
+			(SaveTaggedField(Stream, ++Id, Field), ...);
+		}, Fields);
+	}
+
+	// fields unknown to this reader or sent with another wire type are skipped by their size,
+	// fields the writer did not send keep their values.
+	template<typename StreamType, typename TupleType>
+	void LoadTagged(StreamType& Stream, TupleType Fields, std::uint32_t SchemaHash)
+	{
+		static_assert(!IsBitStream<StreamType>, "tagged types need a byte stream.");
+		constexpr std::size_t FieldNum = std::tuple_size_v<TupleType>;
+
+		if (!Stream.IsValidInput())
+			return;
+
+		std::uint32_t WriterHash = 0;
+		std::uint32_t Num = 0;
+		Stream.template PopAs<std::uint32_t>(WriterHash);
+		LoadVarint(Stream, Num);
+
+		if (!Stream.IsValidInput())
+			return;
+
+		if (WriterHash == SchemaHash && Num == FieldNum)
+		{
+			std::apply([&](auto&... Field)
+			{
+				std::uint32_t Id = 0;
+				(LoadTaggedFieldInOrder(Stream, ++Id, Field), ...);
+			}, Fields);
+			return;
+		}
+
+		for (std::uint32_t i = 0; i < Num && Stream.IsValidInput(); ++i)
+		{
+			std::uint32_t Key = 0;
+			LoadVarint(Stream, Key);
+
+			auto Wire = static_cast<ETagWire>(Key & ((1u << TagWireBits) - 1));
+			if (!Stream.IsValidInput() || Wire > ETagWire::Bytes)
+			{
+				Stream.MarkInputInvalid();
+				return;
+			}
+
+			std::uint32_t Length = TagWireSize(Wire);
+			if (Wire == ETagWire::Bytes)
+				Length = LoadSize(Stream);
+
+			if (!Stream.IsValidInput())
+				return;
+
+			if (!LoadTaggedById(Stream, Fields, Key >> TagWireBits, Wire, Length, std::make_index_sequence<FieldNum>{}))
+				SkipBytes(Stream, Length);
+		}
+	}
+
+	// like TK_SERIAL, but every field is tagged with its position so readers and writers built
+	// from different versions of the type still understand each other. only append fields, and
+	// never reuse a position for a field of another meaning.
+	#define TK_SERIAL_TAGGED(...) \
+	using SerialTagged = void;\
+	template<typename T>\
+	void Load(T& Stream)\
+	{\
+		constexpr std::uint32_t SchemaHash = TK::HashTaggedSchema<decltype(SerialFields())>(#__VA_ARGS__);\
+		TK::LoadTagged(Stream, SerialFields(), SchemaHash);\
+	}\
+	template<typename T>\
+	void Save(T& Stream) const\
+	{\
+		constexpr std::uint32_t SchemaHash = TK::HashTaggedSchema<decltype(SerialFields())>(#__VA_ARGS__);\
+		TK::SaveTagged(Stream, SerialFields(), SchemaHash);\
+	}\
+	auto SerialFields()\
+	{\
+		return TK::MakeSerialFields(__VA_ARGS__);\
+	}\
+	auto SerialFields() const\
+	{\
+		return TK::MakeSerialFields(__VA_ARGS__);\
+	}
+}
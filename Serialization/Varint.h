@@ -0,0 +1,134 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace TK
+{
+	// wire encoding of integers wider than one byte, and of every container length prefix.
+	// Fixed writes them at full width (length prefixes as uint32), Varint writes LEB128,
+	// zigzag mapped first for signed types. both ends of a stream must agree on the mode.
+	enum class EIntEncoding : std::uint8_t
+	{
+		Fixed,
+		Varint,
+	};
+
+	template<typename T>
+	inline constexpr bool IsCharType = std::is_same_v<T, char> || std::is_same_v<T, signed char> ||
+		std::is_same_v<T, unsigned char> || std::is_same_v<T, wchar_t> ||
+		std::is_same_v<T, char16_t> || std::is_same_v<T, char32_t>;
+
+	// characters always stay raw, so strings keep their layout in both modes.
+	template<typename T>
+	inline constexpr bool IsVarintEncodable = std::is_integral_v<T> && !std::is_same_v<T, bool> &&
+		!IsCharType<T> && sizeof(T) > 1;
+
+	template<typename T>
+	inline constexpr int MaxVarintBytes = static_cast<int>((sizeof(T) * 8 + 6) / 7);
+
+	constexpr std::uint64_t ZigZagEncode(std::int64_t Value)
+	{
+		return (static_cast<std::uint64_t>(Value) << 1) ^ static_cast<std::uint64_t>(Value >> 63);
+	}
+
+	constexpr std::int64_t ZigZagDecode(std::uint64_t Value)
+	{
+		return static_cast<std::int64_t>(Value >> 1) ^ -static_cast<std::int64_t>(Value & 1);
+	}
+
+	// Dest must have room for MaxVarintBytes<std::uint64_t> bytes. returns bytes written.
+	inline int EncodeVarint(std::uint64_t Value, std::uint8_t* Dest)
+	{
+		int Bytes = 0;
+		while (Value >= 0x80)
+		{
+			Dest[Bytes++] = static_cast<std::uint8_t>(Value | 0x80);
+			Value >>= 7;
+		}
+		Dest[Bytes++] = static_cast<std::uint8_t>(Value);
+		return Bytes;
+	}
+
+	// Value in exactly Bytes bytes, the unused high ones still carry a continuation bit so the
+	// decoders read it like a minimal one. Bytes must be at least GetVarintSize(Value).
+	inline void EncodeVarintPadded(std::uint64_t Value, std::uint8_t* Dest, int Bytes)
+	{
+		for (int i = 0; i < Bytes - 1; ++i)
+		{
+			Dest[i] = static_cast<std::uint8_t>(Value | 0x80);
+			Value >>= 7;
+		}
+		Dest[Bytes - 1] = static_cast<std::uint8_t>(Value);
+	}
+
+	constexpr int GetVarintSize(std::uint64_t Value)
+	{
+		int Bytes = 1;
+		while (Value >= 0x80)
+		{
+			Value >>= 7;
+			++Bytes;
+		}
+		return Bytes;
+	}
+
+	// returns bytes consumed, or 0 if the input is truncated or longer than MaxBytes.
+	inline int DecodeVarint(const std::uint8_t* Source, std::int64_t Available, std::uint64_t& Value, int MaxBytes)
+	{
+		std::uint64_t Result = 0;
+		int Limit = Available < MaxBytes ? static_cast<int>(Available) : MaxBytes;
+
+		for (int i = 0; i < Limit; ++i)
+		{
+			std::uint64_t Byte = Source[i];
+			if (i == MaxVarintBytes<std::uint64_t> - 1 && Byte > 1)
+				return 0;
+
+			Result |= (Byte & 0x7F) << (7 * i);
+
+			if ((Byte & 0x80) == 0)
+			{
+				Value = Result;
+				return i + 1;
+			}
+		}
+		return 0;
+	}
+
+	// maps a decoded varint back to T, returns false if it does not fit.
+	template<typename T>
+	bool FromVarint(std::uint64_t Raw, T& Value)
+	{
+		if constexpr (std::is_signed_v<T>)
+		{
+			std::int64_t Signed = ZigZagDecode(Raw);
+			if (Signed < static_cast<std::int64_t>(std::numeric_limits<T>::min()) ||
+				Signed > static_cast<std::int64_t>(std::numeric_limits<T>::max()))
+				return false;
+
+			Value = static_cast<T>(Signed);
+		}
+		else
+		{
+			if (Raw > static_cast<std::uint64_t>(std::numeric_limits<T>::max()))
+				return false;
+
+			Value = static_cast<T>(Raw);
+		}
+		return true;
+	}
+
+	template<typename T>
+	std::uint64_t ToVarint(T Value)
+	{
+		if constexpr (std::is_signed_v<T>)
+		{
+			return ZigZagEncode(static_cast<std::int64_t>(Value));
+		}
+		else
+		{
+			return static_cast<std::uint64_t>(Value);
+		}
+	}
+}
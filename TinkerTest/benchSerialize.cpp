@@ -0,0 +1,898 @@
+﻿#include "gtest/gtest.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/SegmentedStream.h"
+#include "Serialization/BufferPool.h"
+#include "Serialization/LZStream.h"
+#include "Serialization/Checksum.h"
+#include "Serialization/Indexed.h"
+#include "Serialization/Lazy.h"
+#include "Serialization/Arena.h"
+#include "Serialization/SpanWriter.h"
+#include "Serialization/SharedBuffer.h"
+#include "Serialization/LengthSlot.h"
+#include "Serialization/SizeCounter.h"
+#include "Serialization/SerializeFuncs.h"
+
+// benchmarks are disabled by default, run them with --gtest_also_run_disabled_tests --gtest_filter=Bench*
+
+namespace BENCH_SER
+{
+	using FClock = std::chrono::steady_clock;
+
+	// heap allocations made through operator new so far, replaced below for the whole test binary.
+	std::size_t Allocations = 0;
+
+	template<typename FuncType>
+	double MeasureMs(int Iterations, FuncType&& Func)
+	{
+		auto Start = FClock::now();
+		for (int i = 0; i < Iterations; ++i)
+		{
+			Func();
+		}
+		std::chrono::duration<double, std::milli> Elapsed = FClock::now() - Start;
+		return Elapsed.count();
+	}
+
+	struct FFieldHeavy
+	{
+		int A0, A1, A2, A3, A4, A5, A6, A7;
+		float B0, B1, B2, B3, B4, B5, B6, B7;
+		std::int64_t C0, C1, C2, C3;
+		std::uint16_t D0, D1, D2, D3;
+
+		TK_SERIAL(A0, A1, A2, A3, A4, A5, A6, A7,
+			B0, B1, B2, B3, B4, B5, B6, B7,
+			C0, C1, C2, C3,
+			D0, D1, D2, D3)
+	};
+
+	FFieldHeavy MakeFieldHeavy(int Seed)
+	{
+		FFieldHeavy Data {};
+		Data.A0 = Seed; Data.A3 = Seed * 3; Data.A7 = -Seed;
+		Data.B1 = Seed * 0.5f; Data.B6 = -1.25f;
+		Data.C2 = static_cast<std::int64_t>(Seed) << 33;
+		Data.D3 = static_cast<std::uint16_t>(Seed);
+		return Data;
+	}
+}
+
+// every replaced operator new takes its block from malloc or the aligned malloc, and the matching
+// operator delete gives it back there. they stay out of line, so the compiler never sees a free()
+// of memory it thinks came from operator new.
+#if defined(_MSC_VER)
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+namespace BENCH_SER
+{
+	void* AllocateCounted(std::size_t Size)
+	{
+		++Allocations;
+		if (void* Block = std::malloc(Size > 0 ? Size : 1))
+			return Block;
+
+		throw std::bad_alloc();
+	}
+
+	void* AllocateCountedAligned(std::size_t Size, std::align_val_t Alignment)
+	{
+		++Allocations;
+		auto Align = static_cast<std::size_t>(Alignment);
+#if defined(_MSC_VER)
+		void* Block = _aligned_malloc(Size > 0 ? Size : 1, Align);
+#else
+		// aligned_alloc wants a multiple of the alignment
+		void* Block = std::aligned_alloc(Align, Size > 0 ? (Size + Align - 1) / Align * Align : Align);
+#endif
+		if (Block)
+			return Block;
+
+		throw std::bad_alloc();
+	}
+
+	void FreeCountedAligned(void* Block)
+	{
+#if defined(_MSC_VER)
+		_aligned_free(Block);
+#else
+		std::free(Block);
+#endif
+	}
+}
+
+BENCH_NOINLINE void* operator new(std::size_t Size)
+{
+	return BENCH_SER::AllocateCounted(Size);
+}
+
+BENCH_NOINLINE void* operator new[](std::size_t Size)
+{
+	return BENCH_SER::AllocateCounted(Size);
+}
+
+BENCH_NOINLINE void operator delete(void* Block) noexcept
+{
+	std::free(Block);
+}
+
+BENCH_NOINLINE void operator delete[](void* Block) noexcept
+{
+	std::free(Block);
+}
+
+BENCH_NOINLINE void operator delete(void* Block, std::size_t) noexcept
+{
+	std::free(Block);
+}
+
+BENCH_NOINLINE void operator delete[](void* Block, std::size_t) noexcept
+{
+	std::free(Block);
+}
+
+BENCH_NOINLINE void* operator new(std::size_t Size, std::align_val_t Alignment)
+{
+	return BENCH_SER::AllocateCountedAligned(Size, Alignment);
+}
+
+BENCH_NOINLINE void* operator new[](std::size_t Size, std::align_val_t Alignment)
+{
+	return BENCH_SER::AllocateCountedAligned(Size, Alignment);
+}
+
+BENCH_NOINLINE void operator delete(void* Block, std::align_val_t) noexcept
+{
+	BENCH_SER::FreeCountedAligned(Block);
+}
+
+BENCH_NOINLINE void operator delete[](void* Block, std::align_val_t) noexcept
+{
+	BENCH_SER::FreeCountedAligned(Block);
+}
+
+BENCH_NOINLINE void operator delete(void* Block, std::size_t, std::align_val_t) noexcept
+{
+	BENCH_SER::FreeCountedAligned(Block);
+}
+
+BENCH_NOINLINE void operator delete[](void* Block, std::size_t, std::align_val_t) noexcept
+{
+	BENCH_SER::FreeCountedAligned(Block);
+}
+
+TEST(BenchSerialize, DISABLED_StaticVsTypeErased)
+{
+	using namespace BENCH_SER;
+
+	constexpr int Objects = 1000;
+	constexpr int Iterations = 2000;
+
+	std::vector<FFieldHeavy> Source;
+	for (int i = 0; i < Objects; ++i)
+	{
+		Source.push_back(MakeFieldHeavy(i));
+	}
+
+	TK::TMemWriter<0> Writer;
+	Writer.Reserve(Objects * sizeof(FFieldHeavy));
+
+	double ErasedSave = MeasureMs(Iterations, [&]
+	{
+		Writer.Clear();
+		TK::FOutStream& Erased = Writer;
+		for (const auto& Item : Source)
+			Erased & Item;
+	});
+
+	double StaticSave = MeasureMs(Iterations, [&]
+	{
+		Writer.Clear();
+		for (const auto& Item : Source)
+			Writer & Item;
+	});
+
+	std::vector<FFieldHeavy> Copy(Objects);
+
+	double ErasedLoad = MeasureMs(Iterations, [&]
+	{
+		TK::FMemReader Reader(Writer.GetBuffer(), Writer.GetSize());
+		TK::FInStream& Erased = Reader;
+		for (auto& Item : Copy)
+			Erased & Item;
+	});
+
+	double StaticLoad = MeasureMs(Iterations, [&]
+	{
+		TK::FMemReader Reader(Writer.GetBuffer(), Writer.GetSize());
+		for (auto& Item : Copy)
+			Reader & Item;
+	});
+
+	EXPECT_EQ(Copy.back().C2, Source.back().C2);
+
+	std::printf("field heavy save: type erased %.2f ms, static %.2f ms\n", ErasedSave, StaticSave);
+	std::printf("field heavy load: type erased %.2f ms, static %.2f ms\n", ErasedLoad, StaticLoad);
+}
+
+namespace BENCH_SER
+{
+	struct FParticle
+	{
+		float Position[3];
+		float Velocity[3];
+		std::int32_t Life;
+		std::uint32_t Color;
+
+		TK_SERIAL(Position, Velocity, Life, Color)
+	};
+}
+
+TEST(BenchSerialize, DISABLED_TriviallySerializableVector)
+{
+	using namespace BENCH_SER;
+
+	constexpr int Objects = 10000;
+	constexpr int Iterations = 500;
+
+	std::vector<FParticle> Source(Objects);
+	for (int i = 0; i < Objects; ++i)
+	{
+		Source[i] = {{i * 1.0f, 2.0f, 3.0f}, {0.5f, -0.5f, 0.0f}, i, 0xFF00FF00u};
+	}
+
+	TK::TMemWriter<0> Writer;
+	Writer.Reserve(Objects * sizeof(FParticle) + 4);
+
+	double EachSave = MeasureMs(Iterations, [&]
+	{
+		Writer.Clear();
+		TK::SaveSize(Writer, Source.size());
+		for (const auto& Item : Source)
+			Writer & Item;
+	});
+
+	double BulkSave = MeasureMs(Iterations, [&]
+	{
+		Writer.Clear();
+		Writer & Source;
+	});
+
+	std::vector<FParticle> Copy;
+
+	double EachLoad = MeasureMs(Iterations, [&]
+	{
+		TK::FMemReader Reader(Writer.GetBuffer(), Writer.GetSize());
+		Copy.clear();
+		std::uint32_t Num = TK::LoadSize(Reader);
+		for (std::uint32_t i = 0; i < Num; ++i)
+		{
+			FParticle Item {};
+			Reader & Item;
+			Copy.push_back(Item);
+		}
+	});
+
+	double BulkLoad = MeasureMs(Iterations, [&]
+	{
+		TK::FMemReader Reader(Writer.GetBuffer(), Writer.GetSize());
+		Reader & Copy;
+	});
+
+	EXPECT_EQ(Copy.back().Life, Source.back().Life);
+
+	std::printf("particle vector save: per element %.2f ms, bulk %.2f ms\n", EachSave, BulkSave);
+	std::printf("particle vector load: per element %.2f ms, bulk %.2f ms\n", EachLoad, BulkLoad);
+}
+
+TEST(BenchSerialize, DISABLED_SegmentedVsContiguousWriter)
+{
+	using namespace BENCH_SER;
+
+	constexpr int Payload = 8 * 1024 * 1024;
+	constexpr int Chunk = 1024;
+	constexpr int Iterations = 50;
+
+	std::vector<char> Source(Chunk, 'x');
+	std::size_t Written = 0;
+
+	double Contiguous = MeasureMs(Iterations, [&]
+	{
+		TK::TMemWriter<0> Writer;
+		for (int i = 0; i < Payload / Chunk; ++i)
+			Writer.Push(Source.data(), Chunk);
+		Written = Writer.GetSize();
+	});
+
+	double Segmented = MeasureMs(Iterations, [&]
+	{
+		TK::FSegmentedWriter Writer;
+		for (int i = 0; i < Payload / Chunk; ++i)
+			Writer.Push(Source.data(), Chunk);
+		Written = Writer.GetSize();
+	});
+
+	EXPECT_EQ(static_cast<std::size_t>(Payload), Written);
+
+	std::printf("8 MB in 1 KB pushes: TMemWriter<0> %.2f ms, segmented %.2f ms\n", Contiguous, Segmented);
+}
+
+TEST(BenchSerialize, DISABLED_PooledMessageBuffers)
+{
+	using namespace BENCH_SER;
+
+	constexpr int Iterations = 200000;
+	const std::string Payload(600, 'p');
+	std::size_t Sent = 0;
+
+	double Heap = MeasureMs(Iterations, [&]
+	{
+		TK::TMemWriter<64> Message;
+		Message & Payload;
+		Sent += Message.GetSize();
+	});
+
+	double Pooled = MeasureMs(Iterations, [&]
+	{
+		TK::TMemWriter<64, TK::TPoolAllocator<char>> Message;
+		Message & Payload;
+		Sent += Message.GetSize();
+	});
+
+	EXPECT_GT(Sent, 0u);
+
+	const TK::FBufferPoolStats& Stats = TK::FBufferPool::Get().GetStats();
+	std::printf("600 byte messages: std::allocator %.2f ms, pooled %.2f ms (hits %llu, misses %llu)\n", Heap, Pooled,
+		static_cast<unsigned long long>(Stats.Hits), static_cast<unsigned long long>(Stats.Misses));
+}
+
+TEST(BenchSerialize, DISABLED_FixedSizeBlockLoad)
+{
+	using namespace BENCH_SER;
+
+	constexpr int Objects = 1000;
+	constexpr int Iterations = 2000;
+
+	static_assert(TK::FixedEncodedSize<FFieldHeavy> > 0);
+
+	TK::TMemWriter<0> Writer;
+	for (int i = 0; i < Objects; ++i)
+	{
+		Writer & MakeFieldHeavy(i);
+	}
+
+	std::vector<FFieldHeavy> Copy(Objects);
+
+	// calling the member Load skips the block path, every field is bounds checked
+	double Checked = MeasureMs(Iterations, [&]
+	{
+		TK::FMemReader Reader(Writer.GetBuffer(), Writer.GetSize());
+		for (auto& Item : Copy)
+			Item.Load(Reader);
+	});
+
+	double Block = MeasureMs(Iterations, [&]
+	{
+		TK::FMemReader Reader(Writer.GetBuffer(), Writer.GetSize());
+		for (auto& Item : Copy)
+			Reader & Item;
+	});
+
+	EXPECT_EQ(Copy.back().D3, static_cast<std::uint16_t>(Objects - 1));
+
+	std::printf("field heavy load: per field checks %.2f ms, one check per object %.2f ms\n", Checked, Block);
+}
+
+TEST(BenchSerialize, DISABLED_LZCompression)
+{
+	using namespace BENCH_SER;
+
+	constexpr int Objects = 20000;
+	constexpr int Iterations = 20;
+
+	std::vector<FFieldHeavy> Source;
+	for (int i = 0; i < Objects; ++i)
+	{
+		Source.push_back(MakeFieldHeavy(i));
+	}
+
+	TK::TMemWriter<0> Raw;
+	Raw & Source;
+
+	TK::TMemWriter<0> Buffer;
+	Buffer.Reserve(Raw.GetSize());
+
+	double Compress = MeasureMs(Iterations, [&]
+	{
+		Buffer.Clear();
+		TK::TLZWriter<TK::TMemWriter<0>> Writer(Buffer);
+		Writer & Source;
+		Writer.Flush();
+	});
+
+	std::vector<FFieldHeavy> Copy;
+
+	double Decompress = MeasureMs(Iterations, [&]
+	{
+		TK::FMemReader Inner(Buffer.GetBuffer(), Buffer.GetSize());
+		TK::TLZReader<TK::FMemReader> Reader(Inner);
+		Reader & Copy;
+	});
+
+	EXPECT_EQ(Copy.size(), Source.size());
+
+	const double MegaBytes = static_cast<double>(Raw.GetSize()) * Iterations / (1024.0 * 1024.0);
+	std::printf("lz: %zu -> %zu bytes (ratio %.2f), save %.0f MB/s, load %.0f MB/s\n", Raw.GetSize(), Buffer.GetSize(),
+		static_cast<double>(Raw.GetSize()) / Buffer.GetSize(), MegaBytes / (Compress / 1000.0), MegaBytes / (Decompress / 1000.0));
+}
+
+TEST(BenchSerialize, DISABLED_Crc32c)
+{
+	using namespace BENCH_SER;
+
+	constexpr int Size = 16 * 1024 * 1024;
+	constexpr int Iterations = 20;
+
+	std::vector<char> Source(Size);
+	for (int i = 0; i < Size; ++i)
+		Source[i] = static_cast<char>(i * 13);
+
+	std::vector<char> Dest(Size);
+	std::uint32_t Crc = 0;
+
+	double Copy = MeasureMs(Iterations, [&] { std::memcpy(Dest.data(), Source.data(), Size); });
+	double Hash = MeasureMs(Iterations, [&] { Crc = TK::Crc32c(Source.data(), Size, Crc); });
+
+	EXPECT_EQ(Dest, Source);
+
+	const double MegaBytes = static_cast<double>(Size) * Iterations / (1024.0 * 1024.0);
+	std::printf("crc32c (%s): %.0f MB/s, memcpy %.0f MB/s\n", TK::IsCrc32cAccelerated() ? "sse4.2" : "slicing-by-8",
+		MegaBytes / (Hash / 1000.0), MegaBytes / (Copy / 1000.0));
+}
+
+TEST(BenchSerialize, DISABLED_IndexedMapLookup)
+{
+	using namespace BENCH_SER;
+
+	constexpr int Entries = 10000;
+	constexpr int Lookups = 8;
+	constexpr int Iterations = 200;
+
+	std::map<std::string, FFieldHeavy> Table;
+	for (int i = 0; i < Entries; ++i)
+		Table["asset/" + std::to_string(i)] = MakeFieldHeavy(i);
+
+	TK::TMemWriter<0> Plain;
+	Plain & Table;
+
+	TK::TMemWriter<0> Indexed;
+	Indexed & TK::Indexed(Table);
+
+	const std::string Keys[Lookups] = { "asset/1", "asset/77", "asset/512", "asset/2048",
+		"asset/4096", "asset/6000", "asset/8191", "asset/9999" };
+	std::int64_t Sum = 0;
+
+	double Full = MeasureMs(Iterations, [&]
+	{
+		TK::FMemReader Reader(Plain.GetBuffer(), Plain.GetSize());
+		std::map<std::string, FFieldHeavy> Copy;
+		Reader & Copy;
+
+		for (const std::string& Key : Keys)
+			Sum += Copy[Key].A0;
+	});
+
+	double Lookup = MeasureMs(Iterations, [&]
+	{
+		TK::FMemReader Reader(Indexed.GetBuffer(), Indexed.GetSize());
+		TK::TIndexedMapView<std::string, FFieldHeavy> View;
+		Reader & View;
+
+		for (const std::string& Key : Keys)
+		{
+			FFieldHeavy Value {};
+			View.Find(Key, Value);
+			Sum += Value.A0;
+		}
+	});
+
+	EXPECT_EQ(Sum, 2 * Iterations * (1 + 77 + 512 + 2048 + 4096 + 6000 + 8191 + 9999));
+	std::printf("%d lookups in %d entries: full decode %.3f ms, indexed %.3f ms (%zu vs %zu bytes)\n", Lookups, Entries,
+		Full / Iterations, Lookup / Iterations, Plain.GetSize(), Indexed.GetSize());
+}
+
+namespace BENCH_SER
+{
+	struct FBulky
+	{
+		std::vector<FFieldHeavy> Rows;
+		std::map<std::string, int> Tags;
+
+		TK_SERIAL(Rows, Tags)
+	};
+
+	template<typename PayloadType>
+	struct TRelayed
+	{
+		int Route;
+		PayloadType Payload;
+
+		TK_SERIAL(Route, Payload)
+	};
+}
+
+TEST(BenchSerialize, DISABLED_LazyRelay)
+{
+	using namespace BENCH_SER;
+
+	constexpr int Iterations = 2000;
+
+	FBulky Bulky;
+	for (int i = 0; i < 200; ++i)
+	{
+		Bulky.Rows.push_back(MakeFieldHeavy(i));
+		Bulky.Tags["tag" + std::to_string(i)] = i;
+	}
+
+	TRelayed<FBulky> Eager {1, Bulky};
+	TRelayed<TK::TLazy<FBulky>> Deferred {1, TK::TLazy<FBulky>(Bulky)};
+
+	TK::TMemWriter<0> Out;
+	Out.SetIntEncoding(TK::EIntEncoding::Varint);
+
+	TK::TMemWriter<0> EagerIn;
+	TK::TMemWriter<0> DeferredIn;
+	EagerIn.SetIntEncoding(TK::EIntEncoding::Varint);
+	DeferredIn.SetIntEncoding(TK::EIntEncoding::Varint);
+	EagerIn & Eager;
+	DeferredIn & Deferred;
+
+	auto Relay = [&](const TK::TMemWriter<0>& In, auto& Message)
+	{
+		return MeasureMs(Iterations, [&]
+		{
+			TK::FMemReader Reader(In.GetBuffer(), In.GetSize());
+			Reader.SetIntEncoding(TK::EIntEncoding::Varint);
+			Reader & Message;
+
+			Out.Clear();
+			Out & Message;
+		});
+	};
+
+	TRelayed<FBulky> EagerCopy;
+	TRelayed<TK::TLazy<FBulky>> DeferredCopy;
+	double Decoded = Relay(EagerIn, EagerCopy);
+	double Lazy = Relay(DeferredIn, DeferredCopy);
+
+	EXPECT_EQ(Bulky.Rows.size(), DeferredCopy.Payload.Get().Rows.size());
+	std::printf("relay %zu bytes: decode and encode %.4f ms, lazy %.4f ms\n", Out.GetSize(),
+		Decoded / Iterations, Lazy / Iterations);
+}
+
+namespace BENCH_SER
+{
+	struct FUnitState
+	{
+		std::string Name;
+		std::vector<int> Buffs;
+		int Health;
+
+		TK_SERIAL(Name, Buffs, Health)
+	};
+
+	struct FTick
+	{
+		std::vector<FUnitState> Units;
+		std::map<std::string, std::string> Properties;
+
+		TK_SERIAL(Units, Properties)
+	};
+}
+
+TEST(BenchSerialize, DISABLED_ReuseContainers)
+{
+	using namespace BENCH_SER;
+
+	constexpr int Iterations = 5000;
+
+	FTick Tick;
+	for (int i = 0; i < 100; ++i)
+	{
+		Tick.Units.push_back({"unit with a long enough name " + std::to_string(i), {i, i * 2, i * 3}, 100 - i});
+		Tick.Properties["property key " + std::to_string(i)] = "property value long enough to allocate " + std::to_string(i);
+	}
+
+	TK::TMemWriter<0> Writer;
+	Writer & Tick;
+
+	auto Run = [&](bool bReuse, std::size_t& Allocated)
+	{
+		FTick Target;
+		std::size_t Before = Allocations;
+
+		double Ms = MeasureMs(Iterations, [&]
+		{
+			TK::FMemReader Reader(Writer.GetBuffer(), Writer.GetSize());
+			Reader.SetReuseContainers(bReuse);
+			Reader & Target;
+		});
+
+		Allocated = Allocations - Before;
+		EXPECT_EQ(Tick.Units.back().Name, Target.Units.back().Name);
+		return Ms;
+	};
+
+	std::size_t Rebuilt = 0;
+	std::size_t Reused = 0;
+	double RebuildMs = Run(false, Rebuilt);
+	double ReuseMs = Run(true, Reused);
+
+	std::printf("decode into one object %d times: rebuild %.1f ms %.1f allocations each, reuse %.1f ms %.1f allocations each\n",
+		Iterations, RebuildMs, static_cast<double>(Rebuilt) / Iterations, ReuseMs, static_cast<double>(Reused) / Iterations);
+}
+
+namespace BENCH_SER
+{
+	template<template<typename> class AllocatorTemplate>
+	struct TChatLog
+	{
+		using allocator_type = AllocatorTemplate<char>;
+		using StringType = std::basic_string<char, std::char_traits<char>, AllocatorTemplate<char>>;
+
+		TChatLog() = default;
+
+		explicit TChatLog(const allocator_type& Allocator) : Lines(Allocator), Users(Allocator) {}
+
+		std::vector<StringType, AllocatorTemplate<StringType>> Lines;
+		std::map<StringType, int, std::less<StringType>, AllocatorTemplate<std::pair<const StringType, int>>> Users;
+
+		TK_SERIAL(Lines, Users)
+	};
+}
+
+TEST(BenchSerialize, DISABLED_PmrArena)
+{
+	using namespace BENCH_SER;
+
+	constexpr int Iterations = 5000;
+
+	TChatLog<std::allocator> Log;
+	for (int i = 0; i < 50; ++i)
+	{
+		Log.Lines.push_back("a chat line that is long enough to allocate " + std::to_string(i));
+		Log.Users["user name number " + std::to_string(i)] = i;
+	}
+
+	TK::TMemWriter<0> Writer;
+	Writer & Log;
+
+	std::size_t Lines = 0;
+	std::size_t Before = Allocations;
+	double HeapMs = MeasureMs(Iterations, [&]
+	{
+		TK::FMemReader Reader(Writer.GetBuffer(), Writer.GetSize());
+		TChatLog<std::allocator> Message;
+		Reader & Message;
+		Lines += Message.Lines.size();
+	});
+	std::size_t HeapAllocations = Allocations - Before;
+
+	TK::TMessageArena<16 * 1024> Arena;
+	Before = Allocations;
+	double ArenaMs = MeasureMs(Iterations, [&]
+	{
+		TK::FMemReader Reader(Writer.GetBuffer(), Writer.GetSize());
+		{
+			auto Message = Arena.Load<TChatLog<std::pmr::polymorphic_allocator>>(Reader);
+			Lines += Message.Lines.size();
+		}
+		Arena.Reset();
+	});
+	std::size_t ArenaAllocations = Allocations - Before;
+
+	EXPECT_EQ(2u * Iterations * Log.Lines.size(), Lines);
+	std::printf("decode %zu bytes: heap %.1f ms %.1f allocations each, arena %.1f ms %.1f allocations each\n", Writer.GetSize(),
+		HeapMs, static_cast<double>(HeapAllocations) / Iterations, ArenaMs, static_cast<double>(ArenaAllocations) / Iterations);
+}
+
+namespace BENCH_SER
+{
+	// FFieldHeavy streamed one field at a time, as TK_SERIAL did before runs were fused.
+	struct FFieldHeavySingle : FFieldHeavy
+	{
+		template<typename T>
+		void Save(T& Stream) const
+		{
+			Stream & A0 & A1 & A2 & A3 & A4 & A5 & A6 & A7 & B0 & B1 & B2 & B3 & B4 & B5 & B6 & B7 &
+				C0 & C1 & C2 & C3 & D0 & D1 & D2 & D3;
+		}
+
+		template<typename T>
+		void Load(T& Stream)
+		{
+			Stream & A0 & A1 & A2 & A3 & A4 & A5 & A6 & A7 & B0 & B1 & B2 & B3 & B4 & B5 & B6 & B7 &
+				C0 & C1 & C2 & C3 & D0 & D1 & D2 & D3;
+		}
+	};
+}
+
+TEST(BenchSerialize, DISABLED_FusedFieldRuns)
+{
+	using namespace BENCH_SER;
+
+	constexpr int Objects = 1000;
+	constexpr int Iterations = 2000;
+
+	std::vector<FFieldHeavy> Fused;
+	std::vector<FFieldHeavySingle> Single;
+	for (int i = 0; i < Objects; ++i)
+	{
+		Fused.push_back(MakeFieldHeavy(i));
+		Single.push_back({MakeFieldHeavy(i)});
+	}
+
+	TK::TMemWriter<0> Writer;
+	Writer.Reserve(Objects * sizeof(FFieldHeavy));
+
+	auto MeasureSave = [&](const auto& Source)
+	{
+		return MeasureMs(Iterations, [&]
+		{
+			Writer.Clear();
+			for (const auto& Item : Source)
+				Writer & Item;
+		});
+	};
+
+	// a segmented reader keeps the fixed size block path of FMemReader out of the comparison
+	auto MeasureLoad = [&](auto& Dest)
+	{
+		return MeasureMs(Iterations, [&]
+		{
+			TK::FSegmentedReader Reader({{Writer.GetBuffer(), Writer.GetSize()}});
+			for (auto& Item : Dest)
+				Reader & Item;
+		});
+	};
+
+	double SingleSave = MeasureSave(Single);
+	double SingleLoad = MeasureLoad(Single);
+	double FusedSave = MeasureSave(Fused);
+	double FusedLoad = MeasureLoad(Fused);
+
+	EXPECT_EQ(Fused.back().C2, Single.back().C2);
+	std::printf("%d objects x %d: per field save %.1f ms load %.1f ms, fused save %.1f ms load %.1f ms\n", Objects, Iterations,
+		SingleSave, SingleLoad, FusedSave, FusedLoad);
+}
+
+TEST(BenchSerialize, DISABLED_SpanWriterIntoRing)
+{
+	using namespace BENCH_SER;
+
+	constexpr int Iterations = 500000;
+	constexpr std::size_t SlotSize = 2048;
+	constexpr std::size_t SlotNum = 64;
+
+	std::vector<char> Ring(SlotSize * SlotNum);
+	std::vector<FFieldHeavy> Sources;
+	for (int i = 0; i < 16; ++i)
+		Sources.push_back(MakeFieldHeavy(i));
+
+	const std::string Text(700, 't');
+	std::size_t Slot = 0;
+	std::size_t Sent = 0;
+
+	// encode into an owned buffer, then copy into the transport's slot
+	double Copied = MeasureMs(Iterations, [&]
+	{
+		char* Dest = Ring.data() + (Slot++ % SlotNum) * SlotSize;
+		TK::TMemWriter<SlotSize> Writer;
+		Writer & Sources[Slot % Sources.size()] & Text;
+		std::memcpy(Dest, Writer.GetBuffer(), Writer.GetSize());
+		Sent += Writer.GetSize();
+	});
+
+	double Direct = MeasureMs(Iterations, [&]
+	{
+		TK::FSpanWriter Writer(Ring.data() + (Slot++ % SlotNum) * SlotSize, SlotSize);
+		Writer & Sources[Slot % Sources.size()] & Text;
+		Sent += Writer.GetSize();
+	});
+
+	EXPECT_GT(Sent, 0u);
+
+	std::printf("%d messages into ring slots: TMemWriter and memcpy %.2f ms, FSpanWriter %.2f ms\n", Iterations, Copied, Direct);
+}
+
+TEST(BenchSerialize, DISABLED_SharedBufferBroadcast)
+{
+	using namespace BENCH_SER;
+
+	constexpr int Iterations = 200;
+	constexpr int Recipients = 500;
+	const std::string State(4096, 's');
+	std::size_t Queued = 0;
+
+	// every send queue gets its own copy of the encoded bytes
+	double Copied = MeasureMs(Iterations, [&]
+	{
+		TK::TMemWriter<64> Writer;
+		Writer & State;
+
+		std::vector<std::vector<char>> Queues;
+		Queues.reserve(Recipients);
+		for (int i = 0; i < Recipients; ++i)
+			Queues.emplace_back(Writer.GetBuffer(), Writer.GetBuffer() + Writer.GetSize());
+		Queued += Queues.size();
+	});
+
+	double Shared = MeasureMs(Iterations, [&]
+	{
+		TK::TMemWriter<64> Writer;
+		Writer & State;
+		TK::FSharedBuffer Frozen = TK::Freeze(Writer);
+
+		std::vector<TK::FSharedBuffer> Queues;
+		Queues.reserve(Recipients);
+		for (int i = 0; i < Recipients; ++i)
+			Queues.push_back(Frozen);
+		Queued += Queues.size();
+	});
+
+	EXPECT_EQ(static_cast<std::size_t>(2 * Iterations * Recipients), Queued);
+
+	std::printf("4 KB to %d queues: copy per queue %.2f ms, shared buffer %.2f ms\n", Recipients, Copied, Shared);
+}
+
+TEST(BenchSerialize, DISABLED_LengthSlotBackfill)
+{
+	using namespace BENCH_SER;
+
+	constexpr int Iterations = 20000;
+	std::vector<FFieldHeavy> Children;
+	for (int i = 0; i < 32; ++i)
+		Children.push_back(MakeFieldHeavy(i));
+
+	TK::TMemWriter<0> Writer;
+	Writer.SetIntEncoding(TK::EIntEncoding::Varint);
+	std::size_t Written = 0;
+
+	// every child encoded twice, once to measure its prefix
+	double Measured = MeasureMs(Iterations, [&]
+	{
+		Writer.Clear();
+		for (const FFieldHeavy& Child : Children)
+		{
+			TK::FSizeCounter Counter;
+			Counter.SetIntEncoding(Writer.GetIntEncoding());
+			Counter & Child;
+			TK::SaveSize(Writer, Counter.GetSize());
+			Writer & Child;
+		}
+		Written = Writer.GetSize();
+	});
+
+	std::size_t MeasuredSize = Written;
+
+	double Backfilled = MeasureMs(Iterations, [&]
+	{
+		Writer.Clear();
+		for (const FFieldHeavy& Child : Children)
+			TK::SaveSizePrefixed(Writer, Child, TK::GetSizeSlot(Writer));
+		Written = Writer.GetSize();
+	});
+
+	EXPECT_EQ(MeasuredSize, Written);
+
+	std::printf("32 size prefixed children: measure then write %.2f ms, backfilled slot %.2f ms\n", Measured, Backfilled);
+}
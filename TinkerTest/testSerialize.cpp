@@ -1,8 +1,28 @@
-#include "gtest/gtest.h"
+﻿#include "gtest/gtest.h"
+#include <cmath>
+#include <cstring>
 #include <typeinfo>
 #include "../Serialization/MemoryReader.h"
 #include "../Serialization/SerializeFuncs.h"
 #include "Serialization/MemoryWriter.h"
+#include "Serialization/Delta.h"
+#include "Serialization/Quantize.h"
+#include "Serialization/Message.h"
+#include "Serialization/SizeCounter.h"
+#include "Serialization/SegmentedStream.h"
+#include "Serialization/BufferPool.h"
+#include "Serialization/FileStream.h"
+#include "Serialization/MappedReader.h"
+#include "Serialization/LZStream.h"
+#include "Serialization/Checksum.h"
+#include "Serialization/LargeObject.h"
+#include "Serialization/Tagged.h"
+#include "Serialization/Indexed.h"
+#include "Serialization/Lazy.h"
+#include "Serialization/Arena.h"
+#include "Serialization/SpanWriter.h"
+#include "Serialization/SharedBuffer.h"
+#include "Serialization/LengthSlot.h"
 #include <string_view>
 
 namespace TEST_SER
@@ -110,3 +130,2153 @@ TEST(Serialize, FDummy)
 
 	Source.Check(Copy);
 }
+
+TEST(Serialize, TypeErasedStream)
+{
+	TEST_SER::FUserData Source;
+	Source.Name = "Erased";
+	Source.Scores = {7, 8, 9};
+	Source.Attributes = {{"MP", 50}};
+	Source.Dummy.bChecked = true;
+	Source.Dummy.ID = 42;
+	Source.Dummy.Position[0] = 1.0f;
+	Source.Dummy.Position[1] = -1.0f;
+	Source.Dummy.Position[2] = 0.5f;
+	Source.Dummy2.NickName = L"Tinker";
+
+	TK::TMemWriter Static;
+	Static & Source;
+
+	TK::TMemWriter ErasedWriter;
+	TK::FOutStream& Erased = ErasedWriter;
+	Erased & Source;
+
+	ASSERT_EQ(Static.GetSize(), ErasedWriter.GetSize());
+	EXPECT_EQ(0, std::memcmp(Static.GetBuffer(), ErasedWriter.GetBuffer(), Static.GetSize()));
+
+	TK::FMemReader Reader(ErasedWriter.GetBuffer(), ErasedWriter.GetSize());
+	TK::FInStream& ErasedReader = Reader;
+	TEST_SER::FUserData Copy;
+	ErasedReader & Copy;
+
+	EXPECT_TRUE(Reader.IsValidInput());
+	Source.Check(Copy);
+}
+
+namespace TEST_SER
+{
+	enum class EColor : std::uint16_t
+	{
+		Red = 1,
+		Blue = 300,
+	};
+
+	struct FCompact
+	{
+		std::int64_t Delta;
+		std::uint32_t Count;
+		short Small[2];
+		EColor Color;
+		std::vector<std::int32_t> Ids;
+
+		TK_SERIAL(Delta, Count, Small, Color, Ids)
+	};
+}
+
+TEST(Serialize, VarintEncoding)
+{
+	TEST_SER::FUserData Source;
+	Source.Name = "Compact";
+	Source.Scores = {3, -2, 100000, 0};
+	Source.Attributes = {{"HP", 100}, {"Attack", -3}};
+	Source.Dummy.bChecked = true;
+	Source.Dummy.ID = 7;
+	Source.Dummy.Position[0] = 0.25f;
+	Source.Dummy2.NickName = L"Varint";
+
+	TK::TMemWriter Fixed;
+	Fixed & Source;
+
+	TK::TMemWriter Compact;
+	Compact.SetIntEncoding(TK::EIntEncoding::Varint);
+	Compact & Source;
+
+	EXPECT_LT(Compact.GetSize(), Fixed.GetSize());
+
+	TK::FMemReader Reader(Compact.GetBuffer(), Compact.GetSize());
+	Reader.SetIntEncoding(TK::EIntEncoding::Varint);
+	TEST_SER::FUserData Copy;
+	Reader & Copy;
+
+	EXPECT_TRUE(Reader.IsValidInput());
+	EXPECT_EQ(0, Reader.GetUnreadBytes());
+	Source.Check(Copy);
+
+	TEST_SER::FCompact Extremes { std::numeric_limits<std::int64_t>::min(), 0xFFFFFFFF, {-1, 1}, TEST_SER::EColor::Blue, {-5, 5} };
+	Compact.Clear();
+	Compact & Extremes;
+	EXPECT_EQ(10 + 5 + 2 + 2 + 1 + 2, static_cast<int>(Compact.GetSize()));
+
+	TK::FMemReader ExtremesReader(Compact.GetBuffer(), Compact.GetSize());
+	ExtremesReader.SetIntEncoding(TK::EIntEncoding::Varint);
+	TK::FInStream& Erased = ExtremesReader;
+	TEST_SER::FCompact ExtremesCopy {};
+	Erased & ExtremesCopy;
+
+	EXPECT_TRUE(ExtremesReader.IsValidInput());
+	EXPECT_EQ(Extremes.Delta, ExtremesCopy.Delta);
+	EXPECT_EQ(Extremes.Count, ExtremesCopy.Count);
+	EXPECT_EQ(Extremes.Small[0], ExtremesCopy.Small[0]);
+	EXPECT_EQ(Extremes.Color, ExtremesCopy.Color);
+	EXPECT_EQ(Extremes.Ids, ExtremesCopy.Ids);
+
+	// 70000 does not fit in a uint16
+	const std::uint8_t TooLarge[] = {0xF0, 0xA2, 0x04};
+	TK::FMemReader BadReader(TooLarge, sizeof(TooLarge));
+	BadReader.SetIntEncoding(TK::EIntEncoding::Varint);
+	std::uint16_t Value = 0;
+	BadReader & Value;
+	EXPECT_FALSE(BadReader.IsValidInput());
+
+	const std::uint8_t Truncated[] = {0xFF, 0xFF};
+	TK::FMemReader TruncatedReader(Truncated, sizeof(Truncated));
+	TruncatedReader.SetIntEncoding(TK::EIntEncoding::Varint);
+	std::uint32_t Num = 0;
+	TruncatedReader & Num;
+	EXPECT_FALSE(TruncatedReader.IsValidInput());
+
+	// the 10th byte of a uint64 may only carry one bit, on sliced and streaming readers alike
+	const std::uint8_t Overflow[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x02};
+	TK::FMemReader OverflowReader(Overflow, sizeof(Overflow));
+	OverflowReader.SetIntEncoding(TK::EIntEncoding::Varint);
+	std::uint64_t Wide = 1;
+	OverflowReader & Wide;
+	EXPECT_FALSE(OverflowReader.IsValidInput());
+
+	TK::FSegmentedReader OverflowStream({{Overflow, sizeof(Overflow)}});
+	OverflowStream.SetIntEncoding(TK::EIntEncoding::Varint);
+	OverflowStream & Wide;
+	EXPECT_FALSE(OverflowStream.IsValidInput());
+}
+
+namespace TEST_SER
+{
+	struct FPacked
+	{
+		bool bAlive;
+		bool bVisible;
+		int Level;
+		EColor Color;
+		std::int16_t Temperature;
+		std::vector<bool> Flags;
+		float Speed;
+
+		TK_SERIAL(bAlive, bVisible, TK::Ranged<1, 100>(Level), TK::Ranged<EColor::Red, EColor::Blue>(Color),
+			TK::Ranged<-40, 60>(Temperature), Flags, Speed)
+	};
+}
+
+TEST(Serialize, BitStream)
+{
+	TEST_SER::FPacked Source { true, false, 99, TEST_SER::EColor::Blue, -12, {true, false, true, true, false}, 2.5f };
+	for (int i = 0; i < 70; ++i)
+		Source.Flags.push_back(i % 3 == 0);
+
+	TK::FBitWriter Writer;
+	Writer & Source;
+	Writer.Flush();
+
+	// 2 + 7 + 9 + 7 bits, 32 bits size, 75 flag bits, 32 bits float
+	EXPECT_EQ((2 + 7 + 9 + 7 + 32 + 75 + 32 + 7) / 8, static_cast<int>(Writer.GetSize()));
+
+	TK::FBitReader Reader(Writer.GetBuffer(), Writer.GetSize());
+	TEST_SER::FPacked Copy {};
+	Reader & Copy;
+
+	EXPECT_TRUE(Reader.IsValidInput());
+	EXPECT_EQ(Source.bAlive, Copy.bAlive);
+	EXPECT_EQ(Source.bVisible, Copy.bVisible);
+	EXPECT_EQ(Source.Level, Copy.Level);
+	EXPECT_EQ(Source.Color, Copy.Color);
+	EXPECT_EQ(Source.Temperature, Copy.Temperature);
+	EXPECT_EQ(Source.Flags, Copy.Flags);
+	EXPECT_FLOAT_EQ(Source.Speed, Copy.Speed);
+
+	for (int Bits = 1; Bits <= 64; ++Bits)
+		Writer.WriteBits(~std::uint64_t(0) - Bits, Bits);
+	Writer.Flush();
+
+	TK::FBitReader Tail(Writer.GetBuffer(), Writer.GetSize());
+	Tail & Copy;
+	Tail.AlignToByte();
+	for (int Bits = 1; Bits <= 64; ++Bits)
+		EXPECT_EQ((~std::uint64_t(0) - Bits) & TK::LowBitsMask(Bits), Tail.ReadBits(Bits));
+	EXPECT_TRUE(Tail.IsValidInput());
+
+	// byte streams keep the full width but still check the range
+	TK::TMemWriter ByteWriter;
+	ByteWriter & Source;
+	TK::FMemReader ByteReader(ByteWriter.GetBuffer(), ByteWriter.GetSize());
+	TEST_SER::FPacked ByteCopy {};
+	ByteReader & ByteCopy;
+	EXPECT_TRUE(ByteReader.IsValidInput());
+	EXPECT_EQ(Source.Flags, ByteCopy.Flags);
+	EXPECT_EQ(Source.Temperature, ByteCopy.Temperature);
+
+	int OutOfRange = 150;
+	ByteWriter.Clear();
+	ByteWriter & OutOfRange;
+	TK::FMemReader RangeReader(ByteWriter.GetBuffer(), ByteWriter.GetSize());
+	int Level = 0;
+	RangeReader & TK::Ranged<1, 100>(Level);
+	EXPECT_FALSE(RangeReader.IsValidInput());
+	EXPECT_EQ(0, Level);
+}
+
+namespace TEST_SER
+{
+	struct FMovement
+	{
+		float Position[3];
+		std::array<float, 8> Samples;
+		float Speed;
+		float Rotation[4];
+
+		TK_SERIAL(TK::Quantized(Position, -1000.0f, 1000.0f, 20), TK::Half(Samples), TK::Half(Speed),
+			TK::SmallestThree(Rotation))
+	};
+}
+
+TEST(Serialize, Quantize)
+{
+	const float HalfSamples[] = {0.0f, -0.0f, 1.0f, -2.5f, 65504.0f, 1e-7f, 6.1e-5f, 70000.0f, 0.333f};
+	for (float Value : HalfSamples)
+	{
+		std::uint16_t Half;
+		TK::FloatsToHalves(&Value, &Half, 1);
+		EXPECT_EQ(TK::FloatToHalf(Value), Half);
+
+		float Back = TK::HalfToFloat(Half);
+		if (std::fabs(Value) > 65504.0f)
+			EXPECT_TRUE(std::isinf(Back));
+		else
+			EXPECT_NEAR(Value, Back, std::fabs(Value) / 1024.0f + 6e-8f);
+	}
+	EXPECT_TRUE(std::isnan(TK::HalfToFloat(TK::FloatToHalf(std::nanf("")))));
+
+	float Angle = 0.6f;
+	TEST_SER::FMovement Source { {12.5f, -999.0f, 0.001f}, {0.5f, 1.5f, -3.25f, 100.0f, 0.1f, 7.0f, -0.004f, 2048.0f}, 3.75f,
+		{0.0f, std::sin(Angle), 0.0f, -std::cos(Angle)} };
+
+	TK::TMemWriter Writer;
+	Writer & Source;
+	EXPECT_EQ(3 * 3 + 8 * 2 + 2 + 4, static_cast<int>(Writer.GetSize()));
+
+	TK::FMemReader Reader(Writer.GetBuffer(), Writer.GetSize());
+	TEST_SER::FMovement Copy {};
+	Reader & Copy;
+	EXPECT_TRUE(Reader.IsValidInput());
+
+	for (int i = 0; i < 3; ++i)
+		EXPECT_NEAR(Source.Position[i], Copy.Position[i], 2000.0f / ((1 << 20) - 1));
+
+	for (int i = 0; i < 8; ++i)
+		EXPECT_NEAR(Source.Samples[i], Copy.Samples[i], std::fabs(Source.Samples[i]) / 1024.0f);
+
+	EXPECT_FLOAT_EQ(Source.Speed, Copy.Speed);
+
+	// the rotation may come back negated, q and -q are the same rotation
+	float Dot = 0.0f;
+	for (int i = 0; i < 4; ++i)
+		Dot += Source.Rotation[i] * Copy.Rotation[i];
+	EXPECT_NEAR(1.0f, std::fabs(Dot), 1e-4f);
+
+	TK::FBitWriter BitWriter;
+	BitWriter & Source;
+	BitWriter.Flush();
+	EXPECT_EQ((3 * 20 + 8 * 16 + 16 + 32 + 7) / 8, static_cast<int>(BitWriter.GetSize()));
+
+	TK::FBitReader BitReader(BitWriter.GetBuffer(), BitWriter.GetSize());
+	TEST_SER::FMovement BitCopy {};
+	BitReader & BitCopy;
+	EXPECT_TRUE(BitReader.IsValidInput());
+	EXPECT_EQ(0, std::memcmp(Copy.Position, BitCopy.Position, sizeof(Copy.Position)));
+	EXPECT_EQ(Copy.Samples, BitCopy.Samples);
+	EXPECT_EQ(0, std::memcmp(Copy.Rotation, BitCopy.Rotation, sizeof(Copy.Rotation)));
+
+	// the range ends survive the widest quantization, scalar and batched
+	for (auto Range : {std::make_pair(0.0f, 1.0f), std::make_pair(-1000.0f, 1000.0f)})
+	{
+		float Ends[9] = {Range.second, Range.first, Range.second, Range.second, Range.first, Range.second, Range.first, Range.second, 2e9f};
+		float End = Range.second;
+
+		TK::TMemWriter<0> EndWriter;
+		EndWriter & TK::Quantized(Ends, Range.first, Range.second, 24) & TK::Quantized(End, Range.first, Range.second, 24);
+
+		TK::FMemReader EndReader(EndWriter.GetBuffer(), EndWriter.GetSize());
+		float EndsCopy[9] {};
+		float EndCopy = 0.0f;
+		EndReader & TK::Quantized(EndsCopy, Range.first, Range.second, 24) & TK::Quantized(EndCopy, Range.first, Range.second, 24);
+		ASSERT_TRUE(EndReader.IsValidInput());
+
+		const float Tolerance = (Range.second - Range.first) / ((1 << 24) - 1);
+		for (int i = 0; i < 9; ++i)
+			EXPECT_NEAR(i == 8 ? Range.second : Ends[i], EndsCopy[i], Tolerance);
+		EXPECT_NEAR(End, EndCopy, Tolerance);
+	}
+}
+
+namespace TEST_SER
+{
+	struct FUnit
+	{
+		int HP;
+		float Position[3];
+		std::string Name;
+		EColor Color;
+
+		TK_SERIAL(HP, Position, Name, TK::Ranged<EColor::Red, EColor::Blue>(Color))
+	};
+
+	struct FWorld
+	{
+		std::uint32_t Tick;
+		FUnit Player;
+		std::vector<FUnit> Units;
+		std::map<int, FUnit> Named;
+		std::vector<int> Scores;
+
+		TK_SERIAL(Tick, Player, Units, Named, Scores)
+	};
+
+	void CheckUnit(const FUnit& A, const FUnit& B)
+	{
+		EXPECT_EQ(A.HP, B.HP);
+		EXPECT_EQ(0, std::memcmp(A.Position, B.Position, sizeof(A.Position)));
+		EXPECT_EQ(A.Name, B.Name);
+		EXPECT_EQ(A.Color, B.Color);
+	}
+
+	void CheckWorld(const FWorld& A, const FWorld& B)
+	{
+		EXPECT_EQ(A.Tick, B.Tick);
+		CheckUnit(A.Player, B.Player);
+		ASSERT_EQ(A.Units.size(), B.Units.size());
+		for (std::size_t i = 0; i < A.Units.size(); ++i)
+			CheckUnit(A.Units[i], B.Units[i]);
+		ASSERT_EQ(A.Named.size(), B.Named.size());
+		for (const auto& [Key, Unit] : A.Named)
+			CheckUnit(Unit, B.Named.at(Key));
+		EXPECT_EQ(A.Scores, B.Scores);
+	}
+}
+
+TEST(Serialize, Delta)
+{
+	using namespace TEST_SER;
+
+	FWorld Baseline;
+	Baseline.Tick = 100;
+	Baseline.Player = {100, {1.0f, 2.0f, 3.0f}, "Player", EColor::Red};
+	for (int i = 0; i < 100; ++i)
+		Baseline.Units.push_back({i, {0.0f, 0.0f, static_cast<float>(i)}, "Unit" + std::to_string(i), EColor::Blue});
+	Baseline.Named = {{1, {1, {}, "One", EColor::Red}}, {2, {2, {}, "Two", EColor::Red}}, {3, {3, {}, "Three", EColor::Red}}};
+	Baseline.Scores = {1, 2, 3};
+
+	FWorld Current = Baseline;
+	Current.Tick = 101;
+	Current.Player.Position[1] = -2.0f;
+	Current.Units[42].HP = 0;
+	Current.Units.push_back({1000, {}, "Late", EColor::Red});
+	Current.Named.erase(2);
+	Current.Named[3].Name = "Renamed";
+	Current.Named[4] = {4, {}, "Four", EColor::Blue};
+
+	TK::TMemWriter<0> Full;
+	Full & Current;
+
+	TK::TMemWriter<0> Delta;
+	TK::SaveDelta(Delta, Current, Baseline);
+	EXPECT_LT(Delta.GetSize() * 10, Full.GetSize());
+
+	FWorld Copy = Baseline;
+	TK::FMemReader Reader(Delta.GetBuffer(), Delta.GetSize());
+	TK::LoadDelta(Reader, Copy);
+	EXPECT_TRUE(Reader.IsValidInput());
+	EXPECT_EQ(0, Reader.GetUnreadBytes());
+	CheckWorld(Current, Copy);
+
+	// nothing changed costs one mask
+	Delta.Clear();
+	TK::SaveDelta(Delta, Current, Current);
+	EXPECT_EQ(1u, Delta.GetSize());
+
+	// shrinking containers and bit streams
+	Current.Units.resize(10);
+	Current.Scores.clear();
+	TK::FBitWriter BitWriter;
+	BitWriter.SetIntEncoding(TK::EIntEncoding::Varint);
+	TK::SaveDelta(BitWriter, Current, Baseline);
+	BitWriter.Flush();
+
+	FWorld BitCopy = Baseline;
+	TK::FBitReader BitReader(BitWriter.GetBuffer(), BitWriter.GetSize());
+	BitReader.SetIntEncoding(TK::EIntEncoding::Varint);
+	TK::LoadDelta(BitReader, BitCopy);
+	EXPECT_TRUE(BitReader.IsValidInput());
+	CheckWorld(Current, BitCopy);
+
+	// a count the input cannot hold is rejected before growing, and a failed delta leaves the baseline alone
+	std::vector<double> Samples {1.0, 2.0};
+	TK::TMemWriter<0> Bogus;
+	TK::SaveSize(Bogus, 1000000u);
+	TK::SaveBits(Bogus, 0b01, 2);
+	Bogus & 5.0 & 6.0 & 7.0;
+
+	TK::FMemReader BogusReader(Bogus.GetBuffer(), Bogus.GetSize());
+	TK::LoadDelta(BogusReader, Samples);
+	EXPECT_FALSE(BogusReader.IsValidInput());
+	EXPECT_EQ((std::vector<double>{1.0, 2.0}), Samples);
+
+	// the tick loads before the cut scores fail, and is not applied either
+	FWorld Changed = Baseline;
+	Changed.Tick = 102;
+	Changed.Scores.push_back(4);
+	TK::TMemWriter<0> Changes;
+	TK::SaveDelta(Changes, Changed, Baseline);
+
+	FWorld Partial = Baseline;
+	TK::FMemReader Cut(Changes.GetBuffer(), Changes.GetSize() - 1);
+	TK::LoadDelta(Cut, Partial);
+	EXPECT_FALSE(Cut.IsValidInput());
+	EXPECT_EQ(Baseline.Tick, Partial.Tick);
+	CheckWorld(Baseline, Partial);
+
+	// removed, renamed and added map entries, changed, dropped and added elements all roll back
+	FWorld Reshaped = Baseline;
+	Reshaped.Player.Name = "Moved";
+	Reshaped.Units[3].HP = -1;
+	Reshaped.Units.resize(50);
+	Reshaped.Named.erase(1);
+	Reshaped.Named[2].Name = "Second";
+	Reshaped.Named[5] = {5, {}, "Five", EColor::Blue};
+	Reshaped.Scores = {1, 2, 3, 4, 5};
+	Changes.Clear();
+	TK::SaveDelta(Changes, Reshaped, Baseline);
+
+	FWorld Restored = Baseline;
+	TK::FMemReader Short(Changes.GetBuffer(), Changes.GetSize() - 1);
+	TK::LoadDelta(Short, Restored);
+	EXPECT_FALSE(Short.IsValidInput());
+	CheckWorld(Baseline, Restored);
+
+	TK::FMemReader Whole(Changes.GetBuffer(), Changes.GetSize());
+	TK::LoadDelta(Whole, Restored);
+	EXPECT_TRUE(Whole.IsValidInput());
+	CheckWorld(Reshaped, Restored);
+}
+
+namespace TEST_SER
+{
+	struct FRecord
+	{
+		std::string Name;
+		std::wstring Title;
+		std::uint8_t Flags;
+		std::vector<int> Ids;
+		int Tail;
+
+		TK_SERIAL(Name, Title, Flags, Ids, Tail)
+	};
+
+	struct FRecordView
+	{
+		std::string_view Name;
+		std::wstring_view Title;
+		std::uint8_t Flags;
+		TK::TArrayView<int> Ids;
+		int Tail;
+
+		TK_SERIAL(Name, Title, Flags, Ids, Tail)
+	};
+}
+
+TEST(Serialize, ZeroCopyViews)
+{
+	// an 8 char name keeps the wide title aligned, the flags byte leaves the ids misaligned
+	TEST_SER::FRecord Source { "Recorded", L"Wide", 3, {5, 6, 7, 8}, 9 };
+
+	TK::TMemWriter<0> Writer;
+	Writer & Source;
+
+	TK::FMemReader Reader(Writer.GetBuffer(), Writer.GetSize());
+	TEST_SER::FRecordView View {};
+	Reader & View;
+
+	EXPECT_TRUE(Reader.IsValidInput());
+	EXPECT_EQ(Source.Name, View.Name);
+	EXPECT_EQ(Source.Title, View.Title);
+	EXPECT_EQ(Source.Flags, View.Flags);
+	EXPECT_EQ(Source.Ids, std::vector<int>(View.Ids.begin(), View.Ids.end()));
+	EXPECT_EQ(Source.Tail, View.Tail);
+
+	const char* Begin = Writer.GetBuffer();
+	const char* End = Begin + Writer.GetSize();
+	EXPECT_TRUE(View.Name.data() > Begin && View.Name.data() < End);
+	EXPECT_TRUE(reinterpret_cast<const char*>(View.Ids.GetData()) > Begin && reinterpret_cast<const char*>(View.Ids.GetData()) < End);
+
+	// the ids sit at an odd offset in the buffer and are still read correctly one by one
+	EXPECT_NE(0u, reinterpret_cast<std::uintptr_t>(View.Ids.GetData()) % alignof(int));
+	EXPECT_EQ(7, View.Ids[2]);
+
+	// views save like the containers they point into
+	TK::TMemWriter<0> Copy;
+	Copy & View;
+	ASSERT_EQ(Writer.GetSize(), Copy.GetSize());
+	EXPECT_EQ(0, std::memcmp(Writer.GetBuffer(), Copy.GetBuffer(), Writer.GetSize()));
+
+	// a wide string at an odd offset still loads as a copy, but not as a view into the buffer
+	TK::TMemWriter<0> Odd;
+	Odd & std::string("odd") & std::wstring(L"Wide");
+	ASSERT_NE(0u, reinterpret_cast<std::uintptr_t>(Odd.GetBuffer() + 11) % alignof(wchar_t));
+
+	TK::FMemReader CopyReader(Odd.GetBuffer(), Odd.GetSize());
+	std::string Prefix;
+	std::wstring Wide;
+	CopyReader & Prefix & Wide;
+	EXPECT_TRUE(CopyReader.IsValidInput());
+	EXPECT_EQ(L"Wide", Wide);
+
+	TK::FMemReader ViewReader(Odd.GetBuffer(), Odd.GetSize());
+	std::string_view PrefixView;
+	std::wstring_view WideView;
+	ViewReader & PrefixView & WideView;
+	EXPECT_FALSE(ViewReader.IsValidInput());
+	EXPECT_TRUE(WideView.empty());
+}
+
+namespace TEST_SER
+{
+	struct FVertex
+	{
+		float Position[3];
+		std::int32_t Color;
+		EColor Tint;
+		std::uint8_t Flags[2];
+
+		TK_SERIAL(Position, Color, Tint, Flags)
+	};
+
+	struct FSwapped
+	{
+		std::int32_t A;
+		std::int32_t B;
+
+		TK_SERIAL(B, A)
+	};
+
+	struct FSwappedInside
+	{
+		FSwapped Pair;
+		std::int32_t X;
+
+		TK_SERIAL(Pair, X)
+	};
+
+	struct FMesh
+	{
+		std::vector<FVertex> Vertices;
+		std::array<FSwapped, 2> Pairs;
+		FVertex Corners[2];
+
+		TK_SERIAL(Vertices, Pairs, Corners)
+	};
+
+	// the reference encoding, every element saved field by field
+	template<typename StreamType, typename T>
+	void SaveEach(StreamType& Stream, const std::vector<T>& Data)
+	{
+		TK::SaveSize(Stream, Data.size());
+		for (const T& Item : Data)
+			Stream & Item;
+	}
+}
+
+TEST(Serialize, TriviallySerializable)
+{
+	using namespace TEST_SER;
+
+	static_assert(TK::IsTriviallySerializable<FVertex>);
+	static_assert(TK::IsTriviallySerializable<FSwapped>);
+	static_assert(!TK::IsTriviallySerializable<FDummy>, "bool and padding");
+	static_assert(!TK::IsTriviallySerializable<FMovement>, "proxies");
+	static_assert(!TK::IsTriviallySerializable<FMesh>);
+
+	EXPECT_TRUE(TK::HasSerialLayout<FVertex>());
+	EXPECT_FALSE(TK::HasSerialLayout<FSwapped>());
+	EXPECT_FALSE(TK::HasSerialLayout<FSwappedInside>());
+
+	// a nested type with its fields out of order keeps the outer one off the raw path
+	std::vector<FSwappedInside> Nested { {{1, 2}, 3}, {{4, 5}, 6} };
+	for (auto Encoding : {TK::EIntEncoding::Fixed, TK::EIntEncoding::Varint})
+	{
+		TK::TMemWriter<0> Bulk;
+		Bulk.SetIntEncoding(Encoding);
+		Bulk & Nested;
+
+		TK::TMemWriter<0> Each;
+		Each.SetIntEncoding(Encoding);
+		SaveEach(Each, Nested);
+
+		ASSERT_EQ(Each.GetSize(), Bulk.GetSize());
+		EXPECT_EQ(0, std::memcmp(Each.GetBuffer(), Bulk.GetBuffer(), Bulk.GetSize()));
+
+		TK::FMemReader Reader(Bulk.GetBuffer(), Bulk.GetSize());
+		Reader.SetIntEncoding(Encoding);
+		std::uint32_t Num = TK::LoadSize(Reader);
+		FSwappedInside First {};
+		Reader & First;
+		EXPECT_EQ(2u, Num);
+		EXPECT_EQ(1, First.Pair.A);
+		EXPECT_EQ(2, First.Pair.B);
+	}
+
+	std::vector<FVertex> Vertices;
+	for (int i = 0; i < 100; ++i)
+	{
+		Vertices.push_back({{i * 1.0f, -i * 0.5f, 3.0f}, i * 1000, EColor::Blue, {std::uint8_t(i), 2}});
+	}
+
+	FMesh Source { Vertices, {{{1, 2}, {3, 4}}}, {Vertices[1], Vertices[2]} };
+
+	for (auto Encoding : {TK::EIntEncoding::Fixed, TK::EIntEncoding::Varint})
+	{
+		TK::TMemWriter<0> Bulk;
+		Bulk.SetIntEncoding(Encoding);
+		Bulk & Source.Vertices;
+
+		TK::TMemWriter<0> Each;
+		Each.SetIntEncoding(Encoding);
+		SaveEach(Each, Source.Vertices);
+
+		ASSERT_EQ(Each.GetSize(), Bulk.GetSize());
+		EXPECT_EQ(0, std::memcmp(Each.GetBuffer(), Bulk.GetBuffer(), Bulk.GetSize()));
+
+		TK::TMemWriter<0> Writer;
+		Writer.SetIntEncoding(Encoding);
+		Writer & Source;
+
+		TK::FMemReader Reader(Writer.GetBuffer(), Writer.GetSize());
+		Reader.SetIntEncoding(Encoding);
+		FMesh Copy {};
+		Reader & Copy;
+
+		ASSERT_TRUE(Reader.IsValidInput());
+		EXPECT_EQ(0u, Reader.GetUnreadBytes());
+		ASSERT_EQ(Source.Vertices.size(), Copy.Vertices.size());
+		EXPECT_EQ(0, std::memcmp(Source.Vertices.data(), Copy.Vertices.data(), sizeof(FVertex) * Source.Vertices.size()));
+		EXPECT_EQ(3, Copy.Pairs[1].A);
+		EXPECT_EQ(4, Copy.Pairs[1].B);
+		EXPECT_EQ(0, std::memcmp(Source.Corners, Copy.Corners, sizeof(Source.Corners)));
+	}
+}
+
+TEST(Serialize, SizeCounter)
+{
+	TEST_SER::FUserData Source;
+	Source.Name = "Counted";
+	Source.Scores = {1, 300, -70000};
+	Source.Attributes = {{"Level", 12}, {"Gold", 99999}};
+	Source.Dummy = {true, 5, {1.0f, 2.0f, 3.0f}};
+	Source.Dummy2.NickName = L"Nick";
+
+	for (auto Encoding : {TK::EIntEncoding::Fixed, TK::EIntEncoding::Varint})
+	{
+		TK::FSizeCounter Counter;
+		Counter.SetIntEncoding(Encoding);
+		Counter & Source;
+
+		TK::TMemWriter<0> Writer;
+		Writer.SetIntEncoding(Encoding);
+		Writer.Reserve(Counter.GetSize());
+		const std::size_t Capacity = Writer.GetCapacity();
+		Writer & Source;
+
+		EXPECT_TRUE(Counter.IsValidOutput());
+		EXPECT_EQ(Writer.GetSize(), Counter.GetSize());
+		EXPECT_EQ(Capacity, Writer.GetCapacity());
+	}
+
+	EXPECT_EQ(sizeof(int) + 4 + 3 * sizeof(float), TK::MeasureSize(5, std::vector<float>{1.0f, 2.0f, 3.0f}));
+
+	TK::FMessage Message(7);
+	Message.SetSizeLimit(200);
+	EXPECT_TRUE(Message.CanPack(Source));
+	EXPECT_FALSE(Message.CanPack(std::string(300, 'x')));
+
+	Message.Pack(Source);
+	EXPECT_EQ(TK::FMessage::GetHeadSize() + TK::MeasureSize(Source), Message.GetSize());
+
+	Message.ClearContent();
+	EXPECT_EQ(static_cast<std::size_t>(TK::FMessage::GetHeadSize()), Message.GetSize());
+	EXPECT_EQ(7, Message.GetHeader()->Tag);
+
+	// varint messages are measured in varint, ten bytes for a large uint64 and one for a small one
+	TK::FMessage Varint(8);
+	Varint.SetIntEncoding(TK::EIntEncoding::Varint);
+	Varint.SetSizeLimit(TK::FMessage::GetHeadSize() + 3 * 10);
+
+	std::uint64_t Large[3] = {~std::uint64_t(0), ~std::uint64_t(0) - 1, std::uint64_t(1) << 63};
+	EXPECT_TRUE(Varint.CanPack(Large));
+	EXPECT_FALSE(Varint.CanPack(Large, std::uint8_t(1)));
+
+	std::uint64_t Small[4] = {1, 2, 3, 4};
+	EXPECT_TRUE(Varint.CanPack(Large[0], Large[1], Small));
+
+	Varint.Pack(Large);
+	EXPECT_EQ(static_cast<std::size_t>(TK::FMessage::GetHeadSize() + 3 * 10), Varint.GetSize());
+	EXPECT_EQ(0, Varint.GetAvailableSpace());
+	EXPECT_FALSE(Varint.CanPack(std::uint8_t(1)));
+}
+
+TEST(Serialize, SegmentedStream)
+{
+	TEST_SER::FUserData Source;
+	Source.Name = std::string(300, 'n');
+	Source.Scores.assign(100, 42);
+	Source.Attributes = {{"Level", 12}, {"Gold", 99999}};
+	Source.Dummy = {true, 5, {1.0f, 2.0f, 3.0f}};
+	Source.Dummy2.NickName = L"Segmented";
+
+	TK::TMemWriter<0> Flat;
+	Flat & Source;
+
+	TK::TSegmentedWriter<64> Writer;
+	Writer & Source;
+
+	ASSERT_EQ(Flat.GetSize(), Writer.GetSize());
+	EXPECT_EQ((Flat.GetSize() + 63) / 64, Writer.GetSegmentNum());
+
+	std::vector<TK::FIoSlice> Slices = Writer.GetSlices();
+	std::string Joined;
+	for (const auto& Slice : Slices)
+	{
+		EXPECT_LE(Slice.Size, 64u);
+		Joined.append(static_cast<const char*>(Slice.Data), Slice.Size);
+	}
+	EXPECT_EQ(std::string(Flat.GetBuffer(), Flat.GetSize()), Joined);
+
+	std::vector<char> Copied(Writer.GetSize());
+	Writer.CopyTo(Copied.data());
+	EXPECT_EQ(0, std::memcmp(Flat.GetBuffer(), Copied.data(), Copied.size()));
+
+	TK::FSegmentedReader Reader(Slices);
+	TEST_SER::FUserData Copy;
+	Reader & Copy;
+
+	EXPECT_TRUE(Reader.IsValidInput());
+	EXPECT_EQ(0, Reader.GetUnreadBytes());
+	Source.Check(Copy);
+
+	Reader.Pop<int>();
+	EXPECT_FALSE(Reader.IsValidInput());
+
+	// cleared segments are reused by the next writer on this thread
+	std::size_t Segments = Writer.GetSegmentNum();
+	Writer.Clear();
+	EXPECT_EQ(0u, Writer.GetSize());
+	EXPECT_GE(TK::TSegmentPool<64>::Get().GetCachedNum(), Segments);
+
+	TK::TSegmentedWriter<64> Next;
+	Next & Source;
+	EXPECT_EQ(TK::TSegmentPool<64>::Get().GetCachedNum(), 0u);
+}
+
+TEST(Serialize, BufferPool)
+{
+	EXPECT_EQ(0, TK::FBufferPool::GetSizeClass(1));
+	EXPECT_EQ(0, TK::FBufferPool::GetSizeClass(64));
+	EXPECT_EQ(1, TK::FBufferPool::GetSizeClass(65));
+	EXPECT_EQ(-1, TK::FBufferPool::GetSizeClass((std::size_t(1) << TK::FBufferPool::MaxClassBits) + 1));
+
+	TK::FBufferPool& Pool = TK::FBufferPool::Get();
+	const std::string Payload(1000, 'p');
+
+	{
+		TK::FMessage Warmup(1);
+		Warmup.Reserve(2048);
+	}
+
+	Pool.ResetStats();
+	for (int i = 0; i < 10; ++i)
+	{
+		TK::FMessage Message(1);
+		Message.Reserve(2048);
+		Message.Pack(Payload);
+		ASSERT_TRUE(Message.UpdateHeader());
+
+		TK::FMemReader Reader(Message.GetBuffer() + TK::FMessage::GetHeadSize(), Message.GetSize() - TK::FMessage::GetHeadSize());
+		EXPECT_EQ(Payload, Reader.Pop<std::string>());
+	}
+
+	EXPECT_EQ(10u, Pool.GetStats().Hits);
+	EXPECT_EQ(0u, Pool.GetStats().Misses);
+
+	TK::TMemWriter<0, TK::TPoolAllocator<char>> Writer;
+	Writer & Payload;
+	EXPECT_EQ(sizeof(std::uint32_t) + Payload.size(), Writer.GetSize());
+}
+
+namespace TEST_SER
+{
+	struct FStats
+	{
+		bool bActive;
+		std::int32_t Level;
+		EColor Color;
+		std::array<float, 3> Position;
+		FSwapped Pair;
+
+		TK_SERIAL(bActive, TK::Ranged<1, 100>(Level), Color, Position, Pair)
+	};
+}
+
+namespace TEST_SER
+{
+	// claims 8 bytes but reads 4
+	struct FShortRead
+	{
+		std::int32_t Value {0};
+
+		template<typename T>
+		void Load(T& Stream) { Stream & Value; }
+
+		template<typename T>
+		void Save(T& Stream) const { Stream & Value & Value; }
+	};
+
+	struct FShortReadHolder
+	{
+		FShortRead Field;
+
+		TK_SERIAL(Field)
+	};
+}
+
+template<>
+struct TK::TFixedSize<TEST_SER::FShortRead>
+{
+	static constexpr std::size_t Size = 8;
+	static constexpr bool bIntegers = true;
+};
+
+TEST(Serialize, FixedSizeBlock)
+{
+	using namespace TEST_SER;
+
+	static_assert(TK::FixedEncodedSize<FStats> == 1 + 4 + 2 + 12 + 8);
+	static_assert(TK::FixedEncodedSize<FDummy> == 1 + 4 + 12);
+	static_assert(TK::FixedEncodedSize<FMovement> == 0, "quantized proxies");
+	static_assert(TK::FixedEncodedSize<FCompact> == 0, "vector field");
+
+	FStats Source { true, 42, EColor::Blue, {1.0f, 2.0f, 3.0f}, {7, 8} };
+
+	TK::TMemWriter<0> Writer;
+	Writer & Source & Source;
+	EXPECT_EQ(2 * TK::FixedEncodedSize<FStats>, Writer.GetSize());
+
+	TK::FMemReader Reader(Writer.GetBuffer(), Writer.GetSize());
+	FStats First {};
+	FStats Second {};
+	Reader & First & Second;
+
+	EXPECT_TRUE(Reader.IsValidInput());
+	EXPECT_EQ(0, Reader.GetUnreadBytes());
+	EXPECT_EQ(42, Second.Level);
+	EXPECT_EQ(EColor::Blue, Second.Color);
+	EXPECT_EQ(3.0f, Second.Position[2]);
+	EXPECT_EQ(8, Second.Pair.B);
+
+	// one byte short of the second object
+	TK::FMemReader Truncated(Writer.GetBuffer(), Writer.GetSize() - 1);
+	Truncated & First;
+	EXPECT_TRUE(Truncated.IsValidInput());
+	Truncated & Second;
+	EXPECT_FALSE(Truncated.IsValidInput());
+
+	// field values are still validated inside the block
+	std::vector<char> Bad(Writer.GetBuffer(), Writer.GetBuffer() + Writer.GetSize());
+	std::int32_t OutOfRange = 101;
+	std::memcpy(Bad.data() + 1, &OutOfRange, sizeof(OutOfRange));
+
+	TK::FMemReader BadReader(Bad.data(), Bad.size());
+	BadReader & First;
+	EXPECT_FALSE(BadReader.IsValidInput());
+
+	// a block not consumed exactly is rejected
+	TEST_SER::FShortReadHolder Short {};
+	Short.Field.Value = 5;
+	TK::TMemWriter<0> ShortWriter;
+	ShortWriter & Short;
+	ASSERT_EQ(8u, ShortWriter.GetSize());
+
+	TK::FMemReader ShortReader(ShortWriter.GetBuffer(), ShortWriter.GetSize());
+	TEST_SER::FShortReadHolder ShortCopy {};
+	ShortReader & ShortCopy;
+	EXPECT_FALSE(ShortReader.IsValidInput());
+
+	// integers make the size vary in varint mode, those objects decode field by field
+	TK::TMemWriter<0> Varint;
+	Varint.SetIntEncoding(TK::EIntEncoding::Varint);
+	Varint & Source;
+
+	TK::FMemReader VarintReader(Varint.GetBuffer(), Varint.GetSize());
+	VarintReader.SetIntEncoding(TK::EIntEncoding::Varint);
+	FStats VarintCopy {};
+	VarintReader & VarintCopy;
+	EXPECT_TRUE(VarintReader.IsValidInput());
+	EXPECT_EQ(0, VarintReader.GetUnreadBytes());
+	EXPECT_EQ(7, VarintCopy.Pair.A);
+}
+
+TEST(Serialize, FileStream)
+{
+	const std::string Path = testing::TempDir() + "tinker_file_stream.bin";
+
+	TEST_SER::FUserData Source;
+	Source.Name = "Snapshot";
+	Source.Scores.assign(500, 7);
+	Source.Attributes = {{"Level", 12}};
+	Source.Dummy = {true, 5, {1.0f, 2.0f, 3.0f}};
+	Source.Dummy2.NickName = L"File";
+
+	const std::vector<char> Blob(20000, 'b');
+
+	for (bool bDirectIO : {false, true})
+	{
+		TK::FMemReader::SizeType Expected = 0;
+		{
+			TK::FFileWriter Writer(4096);
+			ASSERT_TRUE(Writer.Open(Path.c_str(), bDirectIO));
+
+			for (int i = 0; i < 50; ++i)
+				Writer & Source;
+			Writer & Blob;
+
+			Expected = static_cast<TK::FMemReader::SizeType>(Writer.GetSize());
+			EXPECT_TRUE(Writer.Close());
+		}
+
+		TK::FFileReader Reader(4096);
+		ASSERT_TRUE(Reader.Open(Path.c_str(), bDirectIO));
+		EXPECT_EQ(static_cast<std::uint64_t>(Expected), Reader.GetFileSize());
+
+		for (int i = 0; i < 50; ++i)
+		{
+			TEST_SER::FUserData Copy;
+			Reader & Copy;
+			ASSERT_TRUE(Reader.IsValidInput());
+			Source.Check(Copy);
+		}
+
+		std::vector<char> BlobCopy;
+		Reader & BlobCopy;
+		EXPECT_EQ(Blob, BlobCopy);
+		EXPECT_EQ(0u, Reader.GetUnreadBytes());
+
+		Reader.Pop<int>();
+		EXPECT_FALSE(Reader.IsValidInput());
+	}
+
+	std::remove(Path.c_str());
+
+	TK::FFileReader Missing;
+	EXPECT_FALSE(Missing.Open(Path.c_str()));
+	EXPECT_FALSE(Missing.IsValidInput());
+}
+
+TEST(Serialize, MappedReader)
+{
+	const std::string Path = testing::TempDir() + "tinker_mapped_reader.bin";
+
+	TEST_SER::FRecord Record { "Mappings", L"Wide", 1, {5, 6, 7, 8}, 9 };
+	TEST_SER::FUserData Source {};
+	Source.Name = "Snapshot";
+	Source.Scores.assign(3000, 11);
+	Source.Dummy2.NickName = L"Mapped";
+
+	{
+		TK::FFileWriter Writer;
+		ASSERT_TRUE(Writer.Open(Path.c_str()));
+		Writer & Record & Source;
+		ASSERT_TRUE(Writer.Close());
+	}
+
+	TK::FMappedReader Reader;
+	EXPECT_FALSE(Reader.IsValidInput());
+	ASSERT_TRUE(Reader.Open(Path.c_str(), true));
+
+	TEST_SER::FRecordView View {};
+	TEST_SER::FUserData Copy;
+	Reader & View & Copy;
+
+	EXPECT_TRUE(Reader.IsValidInput());
+	EXPECT_EQ(0, Reader.GetUnreadBytes());
+	EXPECT_EQ("Mappings", View.Name);
+	EXPECT_EQ(Record.Title, View.Title);
+	EXPECT_EQ(4u, View.Ids.GetSize());
+	Source.Check(Copy);
+
+	Reader.Close();
+	EXPECT_FALSE(Reader.IsValidInput());
+	EXPECT_FALSE(Reader.Open((Path + ".missing").c_str()));
+
+	std::remove(Path.c_str());
+}
+
+TEST(Serialize, LZCodec)
+{
+	std::vector<std::string> Inputs = { "", "a", "abcabcabcabcabcabcabcabcabcabc", std::string(100000, 'z') };
+
+	std::string Mixed;
+	std::uint32_t Seed = 1;
+	for (int i = 0; i < 50000; ++i)
+	{
+		Seed = Seed * 1103515245 + 12345;
+		Mixed += (i % 7 == 0) ? static_cast<char>(Seed >> 16) : "0123456789"[i % 10];
+	}
+	Inputs.push_back(Mixed);
+
+	for (const std::string& Input : Inputs)
+	{
+		std::vector<char> Compressed(TK::LZCompressBound(Input.size()));
+		std::size_t Size = TK::LZCompress(Input.data(), Input.size(), Compressed.data());
+		ASSERT_LE(Size, Compressed.size());
+
+		std::string Output(Input.size(), '\0');
+		ASSERT_EQ(static_cast<std::ptrdiff_t>(Input.size()), TK::LZDecompress(Compressed.data(), Size, Output.data(), Output.size()));
+		EXPECT_EQ(Input, Output);
+
+		// too small a destination and truncated input fail cleanly
+		if (!Input.empty())
+		{
+			EXPECT_EQ(-1, TK::LZDecompress(Compressed.data(), Size, Output.data(), Output.size() - 1));
+		}
+		if (Size > 1)
+		{
+			EXPECT_NE(static_cast<std::ptrdiff_t>(Input.size()), TK::LZDecompress(Compressed.data(), Size - 1, Output.data(), Output.size()));
+		}
+	}
+
+	std::vector<char> Compressed(TK::LZCompressBound(Mixed.size()));
+	std::size_t Size = TK::LZCompress(Mixed.data(), Mixed.size(), Compressed.data());
+	EXPECT_LT(Size, Mixed.size() * 3 / 4);
+
+	// flipping bytes must never write or read out of bounds
+	std::string Output(Mixed.size(), '\0');
+	for (std::size_t i = 0; i < Size; i += 97)
+	{
+		std::vector<char> Corrupted(Compressed.begin(), Compressed.begin() + Size);
+		Corrupted[i] = static_cast<char>(Corrupted[i] ^ 0x5A);
+		TK::LZDecompress(Corrupted.data(), Corrupted.size(), Output.data(), Output.size());
+	}
+}
+
+TEST(Serialize, LZStream)
+{
+	std::vector<TEST_SER::FUserData> Source(300);
+	for (int i = 0; i < 300; ++i)
+	{
+		Source[i].Name = "User" + std::to_string(i % 10);
+		Source[i].Scores.assign(50, i);
+		Source[i].Attributes = {{"Level", i}};
+		Source[i].Dummy2.NickName = L"Compressed";
+	}
+
+	TK::TMemWriter<0> Buffer;
+	TK::TLZWriter<TK::TMemWriter<0>> Writer(Buffer);
+	Writer & Source;
+	Writer.Flush();
+
+	ASSERT_TRUE(Writer.IsValidOutput());
+	EXPECT_EQ(Buffer.GetSize(), Writer.GetStoredBytes());
+	EXPECT_LT(Writer.GetStoredBytes() * 4, Writer.GetRawBytes());
+
+	TK::FMemReader Inner(Buffer.GetBuffer(), Buffer.GetSize());
+	TK::TLZReader<TK::FMemReader> Reader(Inner);
+	std::vector<TEST_SER::FUserData> Copy;
+	Reader & Copy;
+
+	ASSERT_TRUE(Reader.IsValidInput());
+	ASSERT_EQ(Source.size(), Copy.size());
+	for (std::size_t i = 0; i < Source.size(); ++i)
+		Source[i].Check(Copy[i]);
+
+	Reader.Pop<int>();
+	EXPECT_FALSE(Reader.IsValidInput());
+
+	// decorators also wrap type erased streams
+	TK::TMemWriter<0> ErasedBuffer;
+	TK::FOutStream& ErasedOut = ErasedBuffer;
+	TK::TLZWriter<TK::FOutStream> ErasedWriter(ErasedOut);
+	ErasedWriter & Source[7];
+	ErasedWriter.Flush();
+
+	TK::FMemReader ErasedInner(ErasedBuffer.GetBuffer(), ErasedBuffer.GetSize());
+	TK::FInStream& ErasedIn = ErasedInner;
+	TK::TLZReader<TK::FInStream> ErasedReader(ErasedIn);
+	TEST_SER::FUserData One;
+	ErasedReader & One;
+	EXPECT_TRUE(ErasedReader.IsValidInput());
+	Source[7].Check(One);
+
+	// a corrupted block header is rejected
+	std::vector<char> Corrupted(Buffer.GetBuffer(), Buffer.GetBuffer() + Buffer.GetSize());
+	Corrupted[0] = 0;
+	Corrupted[1] = 0;
+	Corrupted[2] = 0x10;
+	TK::FMemReader BadInner(Corrupted.data(), Corrupted.size());
+	TK::TLZReader<TK::FMemReader> BadReader(BadInner);
+	BadReader.Pop<int>();
+	EXPECT_FALSE(BadReader.IsValidInput());
+}
+
+TEST(Serialize, Checksum)
+{
+	EXPECT_EQ(0xE3069283u, TK::Crc32c("123456789", 9));
+	EXPECT_EQ(0u, TK::Crc32c(nullptr, 0));
+
+	std::string Long(1000, '\0');
+	for (std::size_t i = 0; i < Long.size(); ++i)
+		Long[i] = static_cast<char>(i * 31);
+
+	const std::uint32_t Whole = TK::Crc32c(Long.data(), Long.size());
+	EXPECT_EQ(Whole, TK::Crc32c(Long.data() + 3, Long.size() - 3, TK::Crc32c(Long.data(), 3)));
+
+	TEST_SER::FUserData Source;
+	Source.Name = "Checked";
+	Source.Scores = {1, 2, 3};
+	Source.Dummy = {true, 5, {1.0f, 2.0f, 3.0f}};
+	Source.Dummy2.NickName = L"Crc";
+
+	TK::TMemWriter<0> Buffer;
+	TK::TCrcWriter<TK::TMemWriter<0>> Writer(Buffer);
+	Writer & Source;
+	Writer.WriteCrc();
+	EXPECT_EQ(TK::Crc32c(Buffer.GetBuffer(), Buffer.GetSize() - 4), Writer.GetCrc());
+
+	{
+		TK::FMemReader Inner(Buffer.GetBuffer(), Buffer.GetSize());
+		TK::TCrcReader<TK::FMemReader> Reader(Inner);
+		TEST_SER::FUserData Copy;
+		Reader & Copy;
+		EXPECT_TRUE(Reader.VerifyCrc());
+		Source.Check(Copy);
+	}
+
+	std::vector<char> Corrupted(Buffer.GetBuffer(), Buffer.GetBuffer() + Buffer.GetSize());
+	Corrupted[5] ^= 1;
+	{
+		TK::FMemReader Inner(Corrupted.data(), Corrupted.size());
+		TK::TCrcReader<TK::FMemReader> Reader(Inner);
+		TEST_SER::FUserData Copy;
+		Reader & Copy;
+		EXPECT_FALSE(Reader.VerifyCrc());
+		EXPECT_FALSE(Reader.IsValidInput());
+	}
+
+	TK::FMessage Message(3);
+	Message.Pack(Source);
+	Message.AppendChecksum();
+	ASSERT_TRUE(Message.UpdateHeader());
+
+	TK::FMemReader Payload(Message.GetBuffer() + TK::FMessage::GetHeadSize(), Message.GetSize() - TK::FMessage::GetHeadSize());
+	ASSERT_TRUE(TK::StripChecksum(Payload));
+	TEST_SER::FUserData Copy;
+	Payload & Copy;
+	EXPECT_TRUE(Payload.IsValidInput());
+	EXPECT_EQ(0, Payload.GetUnreadBytes());
+
+	Message.GetBuffer()[TK::FMessage::GetHeadSize() + 2] ^= 0x40;
+	TK::FMemReader BadPayload(Message.GetBuffer() + TK::FMessage::GetHeadSize(), Message.GetSize() - TK::FMessage::GetHeadSize());
+	EXPECT_FALSE(TK::StripChecksum(BadPayload));
+}
+
+TEST(Serialize, BulkChecksum)
+{
+	std::string Data(100000, '\0');
+	for (std::size_t i = 0; i < Data.size(); ++i)
+		Data[i] = static_cast<char>(i * 7);
+
+	std::vector<std::vector<char>> Chunks;
+	auto Sender = [&](TK::FMessageBase& Message)
+	{
+		Message.UpdateHeader();
+		Chunks.emplace_back(Message.GetBuffer() + TK::FMessage::GetHeadSize(), Message.GetBuffer() + Message.GetSize());
+	};
+
+	TK::SendBulk(1, Data.data(), static_cast<int>(Data.size()), Sender, true);
+	ASSERT_GT(Chunks.size(), 1u);
+
+	std::string Received;
+	TK::FBulkReceiver Receiver(true);
+	Receiver.SetCompletionHandler([&](TK::FMemReader Reader)
+	{
+		Received.assign(static_cast<const char*>(Reader.GetReadPos()), static_cast<std::size_t>(Reader.GetUnreadBytes()));
+	});
+
+	for (const auto& Chunk : Chunks)
+		Receiver.Receive(TK::FMemReader(Chunk.data(), Chunk.size()));
+
+	EXPECT_EQ(TK::FBulkReceiver::EState::Completed, Receiver.GetState());
+	EXPECT_EQ(Data, Received);
+
+	Chunks[1][100] ^= 1;
+	Receiver.Clear();
+	for (const auto& Chunk : Chunks)
+	{
+		Receiver.Receive(TK::FMemReader(Chunk.data(), Chunk.size()));
+		if (Receiver.GetState() == TK::FBulkReceiver::EState::Corrupted)
+			break;
+	}
+	EXPECT_EQ(TK::FBulkReceiver::EState::Corrupted, Receiver.GetState());
+	Chunks[1][100] ^= 1;
+
+	// a cleared checksum flag does not turn the check off
+	Chunks[1][0] &= ~TK::PacketFlag::Checksum;
+	Receiver.Clear();
+	Received.clear();
+	for (const auto& Chunk : Chunks)
+	{
+		Receiver.Receive(TK::FMemReader(Chunk.data(), Chunk.size()));
+		if (Receiver.GetState() == TK::FBulkReceiver::EState::Corrupted)
+			break;
+	}
+	EXPECT_EQ(TK::FBulkReceiver::EState::Corrupted, Receiver.GetState());
+	EXPECT_TRUE(Received.empty());
+
+	// and a receiver without checksums rejects flagged chunks instead of keeping their footers
+	Chunks[1][0] |= TK::PacketFlag::Checksum;
+	TK::FBulkReceiver Plain;
+	Plain.Receive(TK::FMemReader(Chunks[0].data(), Chunks[0].size()));
+	EXPECT_EQ(TK::FBulkReceiver::EState::Corrupted, Plain.GetState());
+}
+
+namespace TEST_SER
+{
+	struct FProfileV1
+	{
+		int Level {0};
+		std::string Name;
+
+		TK_SERIAL_TAGGED(Level, Name)
+	};
+
+	struct FProfileV2
+	{
+		int Level {0};
+		std::string Name;
+		std::vector<int> Items;
+		float Rating {0.0f};
+
+		TK_SERIAL_TAGGED(Level, Name, Items, Rating)
+	};
+
+	struct FProfileWide
+	{
+		std::int64_t Level {-1};
+		std::string Name;
+
+		TK_SERIAL_TAGGED(Level, Name)
+	};
+
+	struct FSession
+	{
+		int ID {0};
+		FProfileV2 Profile;
+		short Tail {0};
+
+		TK_SERIAL(ID, Profile, Tail)
+	};
+
+	template<typename ToType, typename FromType>
+	ToType Convert(const FromType& From, TK::EIntEncoding Encoding)
+	{
+		TK::TMemWriter<0> Writer;
+		Writer.SetIntEncoding(Encoding);
+		Writer & From;
+
+		TK::FMemReader Reader(Writer.GetBuffer(), Writer.GetSize());
+		Reader.SetIntEncoding(Encoding);
+		ToType To;
+		Reader & To;
+
+		EXPECT_TRUE(Reader.IsValidInput());
+		EXPECT_EQ(0, Reader.GetUnreadBytes());
+		return To;
+	}
+}
+
+TEST(Serialize, TaggedFields)
+{
+	using namespace TEST_SER;
+
+	static_assert(TK::HashTaggedSchema<decltype(FProfileV1().SerialFields())>("Level, Name") !=
+		TK::HashTaggedSchema<decltype(FProfileWide().SerialFields())>("Level, Name"), "field sizes are part of the hash.");
+	static_assert(TK::FixedEncodedSize<FProfileV1> == 0 && !TK::IsTriviallySerializable<FProfileV1>);
+
+	FProfileV2 Source;
+	Source.Level = 42;
+	Source.Name = "Tagged";
+	Source.Items = {1, 300, -5};
+	Source.Rating = 4.5f;
+
+	for (TK::EIntEncoding Encoding : {TK::EIntEncoding::Fixed, TK::EIntEncoding::Varint})
+	{
+		FProfileV2 Same = Convert<FProfileV2>(Source, Encoding);
+		EXPECT_EQ(Source.Level, Same.Level);
+		EXPECT_EQ(Source.Name, Same.Name);
+		EXPECT_EQ(Source.Items, Same.Items);
+		EXPECT_EQ(Source.Rating, Same.Rating);
+
+		FProfileV1 Older = Convert<FProfileV1>(Source, Encoding);
+		EXPECT_EQ(Source.Level, Older.Level);
+		EXPECT_EQ(Source.Name, Older.Name);
+
+		FProfileV2 Newer = Convert<FProfileV2>(Older, Encoding);
+		EXPECT_EQ(Source.Level, Newer.Level);
+		EXPECT_EQ(Source.Name, Newer.Name);
+		EXPECT_TRUE(Newer.Items.empty());
+		EXPECT_EQ(0.0f, Newer.Rating);
+	}
+
+	// same width check happens per field, a resized field is skipped in fixed mode
+	FProfileWide Wide = Convert<FProfileWide>(Source, TK::EIntEncoding::Fixed);
+	EXPECT_EQ(-1, Wide.Level);
+	EXPECT_EQ(Source.Name, Wide.Name);
+
+	FSession Session;
+	Session.ID = 7;
+	Session.Profile = Source;
+	Session.Tail = 99;
+	FSession SessionCopy = Convert<FSession>(Session, TK::EIntEncoding::Varint);
+	EXPECT_EQ(Session.ID, SessionCopy.ID);
+	EXPECT_EQ(Source.Items, SessionCopy.Profile.Items);
+	EXPECT_EQ(Session.Tail, SessionCopy.Tail);
+
+	// streams that cannot be sliced skip and bound fields while popping
+	TK::TMemWriter<0> Writer;
+	Writer & Session & Source;
+	TK::FSegmentedReader Segmented({{Writer.GetBuffer(), 5}, {Writer.GetBuffer() + 5, Writer.GetSize() - 5}});
+	FSession SegmentedSession;
+	FProfileV1 SegmentedOlder;
+	Segmented & SegmentedSession & SegmentedOlder;
+	EXPECT_TRUE(Segmented.IsValidInput());
+	EXPECT_EQ(0, Segmented.GetUnreadBytes());
+	EXPECT_EQ(Source.Name, SegmentedSession.Profile.Name);
+	EXPECT_EQ(Source.Level, SegmentedOlder.Level);
+	EXPECT_EQ(Source.Name, SegmentedOlder.Name);
+
+	// the same schema path still holds each field to its length, in fixed mode a uint32 one
+	FProfileV1 Short;
+	Short.Name = "Bounded";
+	TK::TMemWriter<0> ShortWriter;
+	ShortWriter & Short;
+	const std::size_t NameOffset = ShortWriter.GetSize() - sizeof(std::uint32_t) - Short.Name.size() - sizeof(std::uint32_t);
+	ShortWriter & std::uint8_t(0);
+
+	std::uint32_t NameLength = 0;
+	std::memcpy(&NameLength, ShortWriter.GetBuffer() + NameOffset, sizeof(NameLength));
+	EXPECT_EQ(sizeof(std::uint32_t) + Short.Name.size(), NameLength);
+
+	++NameLength;
+	ShortWriter.Overwrite(NameOffset, &NameLength, sizeof(NameLength));
+	TK::FMemReader ShortReader(ShortWriter.GetBuffer(), ShortWriter.GetSize());
+	FProfileV1 ShortCopy;
+	ShortReader & ShortCopy;
+	EXPECT_FALSE(ShortReader.IsValidInput());
+
+	// unknown wire types cannot be skipped
+	TK::TMemWriter<0> Bad;
+	Bad.PushAs<std::uint32_t>(0);
+	TK::SaveVarint(Bad, 1u);
+	TK::SaveVarint(Bad, TK::MakeTagKey(9, static_cast<TK::ETagWire>(6)));
+	TK::FMemReader BadReader(Bad.GetBuffer(), Bad.GetSize());
+	FProfileV1 BadProfile;
+	BadReader & BadProfile;
+	EXPECT_FALSE(BadReader.IsValidInput());
+}
+
+namespace TEST_SER
+{
+	struct FCatalog
+	{
+		std::vector<std::string> Names;
+		std::map<std::string, FDummy> Items;
+		std::map<int, float> Prices;
+
+		TK_SERIAL(TK::Indexed(Names), TK::Indexed(Items), TK::Indexed(Prices))
+	};
+
+	struct FCatalogView
+	{
+		TK::TIndexedVectorView<std::string> Names;
+		TK::TIndexedMapView<std::string, FDummy> Items;
+		TK::TIndexedMapView<int, float> Prices;
+
+		TK_SERIAL(Names, Items, Prices)
+	};
+}
+
+TEST(Serialize, IndexedContainers)
+{
+	using namespace TEST_SER;
+
+	FCatalog Source;
+	for (int i = 0; i < 100; ++i)
+	{
+		std::string Name = "item" + std::to_string(i);
+		Source.Names.push_back(Name);
+		Source.Items[Name] = FDummy{i % 2 == 0, i, {i * 1.0f, 2.0f, 3.0f}};
+		Source.Prices[i * 10] = i * 0.5f;
+	}
+
+	for (TK::EIntEncoding Encoding : {TK::EIntEncoding::Fixed, TK::EIntEncoding::Varint})
+	{
+		TK::TMemWriter<0> Writer;
+		Writer.SetIntEncoding(Encoding);
+		Writer & Source & 77;
+
+		{
+			TK::FMemReader Reader(Writer.GetBuffer(), Writer.GetSize());
+			Reader.SetIntEncoding(Encoding);
+			FCatalog Copy;
+			int Tail = 0;
+			Reader & Copy & Tail;
+			ASSERT_TRUE(Reader.IsValidInput());
+			EXPECT_EQ(Source.Names, Copy.Names);
+			EXPECT_EQ(Source.Prices, Copy.Prices);
+			ASSERT_EQ(Source.Items.size(), Copy.Items.size());
+			Source.Items["item42"].Check(Copy.Items["item42"]);
+			EXPECT_EQ(77, Tail);
+		}
+
+		TK::FMemReader Reader(Writer.GetBuffer(), Writer.GetSize());
+		Reader.SetIntEncoding(Encoding);
+		FCatalogView View;
+		int Tail = 0;
+		Reader & View & Tail;
+		ASSERT_TRUE(Reader.IsValidInput());
+		EXPECT_EQ(77, Tail);
+
+		EXPECT_EQ(100u, View.Names.GetSize());
+		std::string Name;
+		EXPECT_TRUE(View.Names.Get(57, Name));
+		EXPECT_EQ("item57", Name);
+		EXPECT_FALSE(View.Names.Get(100, Name));
+
+		FDummy Item {};
+		EXPECT_TRUE(View.Items.Find("item73", Item));
+		Source.Items["item73"].Check(Item);
+		EXPECT_TRUE(View.Items.Contains("item0"));
+		EXPECT_FALSE(View.Items.Contains("item100"));
+		EXPECT_FALSE(View.Items.Find("zzz", Item));
+
+		float Price = 0.0f;
+		EXPECT_TRUE(View.Prices.Find(990, Price));
+		EXPECT_EQ(49.5f, Price);
+		EXPECT_FALSE(View.Prices.Find(995, Price));
+	}
+
+	// a broken offset table only fails the element it covers
+	TK::TMemWriter<0> Writer;
+	Writer & TK::Indexed(Source.Names);
+	std::vector<char> Bytes(Writer.GetBuffer(), Writer.GetBuffer() + Writer.GetSize());
+	std::uint32_t Bad = 0xFFFF;
+	std::memcpy(Bytes.data() + 4 + 3 * 4, &Bad, 4);
+
+	TK::FMemReader Reader(Bytes.data(), Bytes.size());
+	TK::TIndexedVectorView<std::string> Names;
+	Reader & Names;
+	ASSERT_TRUE(Reader.IsValidInput());
+	std::string Name;
+	EXPECT_FALSE(Names.Get(3, Name));
+	EXPECT_FALSE(Names.Get(4, Name));
+	EXPECT_TRUE(Names.Get(5, Name));
+	EXPECT_EQ("item5", Name);
+}
+
+namespace TEST_SER
+{
+	struct FEnvelope
+	{
+		int Route {0};
+		TK::TLazy<FUserData> Payload;
+		short Tail {0};
+
+		TK_SERIAL(Route, Payload, Tail)
+	};
+}
+
+TEST(Serialize, LazyField)
+{
+	using namespace TEST_SER;
+
+	FUserData Data;
+	Data.Name = "Lazy";
+	Data.Scores = {4, 5, 6};
+	Data.Attributes["Depth"] = 3;
+	Data.Dummy = {true, 9, {1.0f, 2.0f, 3.0f}};
+	Data.Dummy2.NickName = L"Deferred";
+
+	FEnvelope Source;
+	Source.Route = 12;
+	Source.Payload = Data;
+	Source.Tail = 5;
+
+	TK::TMemWriter<0> Writer;
+	Writer & Source;
+
+	TK::FMemReader Reader(Writer.GetBuffer(), Writer.GetSize());
+	FEnvelope Relay;
+	Reader & Relay;
+	ASSERT_TRUE(Reader.IsValidInput());
+	EXPECT_EQ(0, Reader.GetUnreadBytes());
+	EXPECT_EQ(12, Relay.Route);
+	EXPECT_EQ(5, Relay.Tail);
+	EXPECT_FALSE(Relay.Payload.IsDecoded());
+	EXPECT_EQ(Writer.GetBuffer() + 8, Relay.Payload.GetEncodedData());
+
+	// untouched payloads are forwarded as they came, even after a read only access
+	TK::TMemWriter<0> Forwarded;
+	Forwarded & Relay;
+	ASSERT_EQ(Writer.GetSize(), Forwarded.GetSize());
+	EXPECT_EQ(0, std::memcmp(Writer.GetBuffer(), Forwarded.GetBuffer(), Writer.GetSize()));
+
+	Data.Check(Relay.Payload.Get());
+	EXPECT_TRUE(Relay.Payload.IsDecoded());
+	EXPECT_TRUE(Relay.Payload.HasEncoded());
+
+	const TK::TLazy<FUserData> Untouched = Relay.Payload;
+	EXPECT_FALSE(Relay.Payload.IsDetached());
+	EXPECT_TRUE(Untouched.IsDetached());
+	EXPECT_NE(Relay.Payload.GetEncodedData(), Untouched.GetEncodedData());
+	EXPECT_EQ(0, std::memcmp(Relay.Payload.GetEncodedData(), Untouched.GetEncodedData(), Untouched.GetEncodedSize()));
+
+	// detached bytes outlive the buffer they were loaded from
+	TK::TLazy<FUserData> Kept;
+	{
+		TK::TMemWriter<0> Scratch;
+		Scratch & Source;
+		TK::FMemReader ScratchReader(Scratch.GetBuffer(), Scratch.GetSize());
+		FEnvelope Loaded;
+		ScratchReader & Loaded;
+		Loaded.Payload.Detach();
+		Kept = std::move(Loaded.Payload);
+	}
+	TK::TMemWriter<0> KeptWriter;
+	KeptWriter & Kept;
+	TK::TMemWriter<0> Expected;
+	Expected & Untouched;
+	ASSERT_EQ(Expected.GetSize(), KeptWriter.GetSize());
+	EXPECT_EQ(0, std::memcmp(Expected.GetBuffer(), KeptWriter.GetBuffer(), Expected.GetSize()));
+	Data.Check(Kept.Get());
+
+	Relay.Payload.GetMutable().Name = "Changed";
+	EXPECT_FALSE(Relay.Payload.HasEncoded());
+
+	TK::TMemWriter<0> Changed;
+	Changed.SetIntEncoding(TK::EIntEncoding::Varint);
+	Changed & Relay;
+
+	// streams other than FMemReader copy the bytes, the copy outlives the source buffer
+	FEnvelope Copy;
+	{
+		std::vector<char> Bytes(Changed.GetBuffer(), Changed.GetBuffer() + Changed.GetSize());
+		TK::FSegmentedReader Segmented({{Bytes.data(), 3}, {Bytes.data() + 3, Bytes.size() - 3}});
+		Segmented.SetIntEncoding(TK::EIntEncoding::Varint);
+		Segmented & Copy;
+		ASSERT_TRUE(Segmented.IsValidInput());
+	}
+	FEnvelope Copied = Copy;
+	EXPECT_TRUE(Copied.Payload.IsValid());
+	EXPECT_EQ("Changed", Copied.Payload.Get().Name);
+	EXPECT_EQ(Data.Scores, Copied.Payload.Get().Scores);
+
+	// a fixed mode writer re-encodes varint bytes
+	TK::TMemWriter<0> Fixed;
+	Fixed & Copy;
+	TK::FMemReader FixedReader(Fixed.GetBuffer(), Fixed.GetSize());
+	FEnvelope FixedCopy;
+	FixedReader & FixedCopy;
+	EXPECT_EQ("Changed", FixedCopy.Payload.Get().Name);
+
+	// bytes left over after the value do not make a valid object
+	TK::TMemWriter<0> Padded;
+	Padded & 12;
+	TK::SaveSize(Padded, Untouched.GetEncodedSize() + 1);
+	Padded.Push(Untouched.GetEncodedData(), Untouched.GetEncodedSize());
+	Padded & char(0) & short(5);
+
+	TK::FMemReader PaddedReader(Padded.GetBuffer(), Padded.GetSize());
+	FEnvelope Broken;
+	PaddedReader & Broken;
+	EXPECT_TRUE(PaddedReader.IsValidInput());
+	EXPECT_EQ(5, Broken.Tail);
+	EXPECT_FALSE(Broken.Payload.IsValid());
+	EXPECT_TRUE(Broken.Payload.Get().Name.empty());
+}
+
+TEST(Serialize, ReuseContainers)
+{
+	using namespace TEST_SER;
+
+	std::vector<FUserData> Source(3);
+	for (int i = 0; i < 3; ++i)
+	{
+		Source[i].Name = "a fairly long user name " + std::to_string(i);
+		Source[i].Scores = {i, i + 1};
+		Source[i].Attributes["key " + std::to_string(i)] = i;
+		Source[i].Dummy = {true, i, {1.0f, 2.0f, 3.0f}};
+		Source[i].Dummy2.NickName = L"Nick";
+	}
+
+	TK::TMemWriter<0> Writer;
+	Writer & Source;
+
+	std::vector<FUserData> Target(5);
+	Target[0].Name = "a fairly long previous name that needs a heap buffer";
+	Target[1].Attributes["key 1"] = 100;
+	Target[1].Attributes["stale"] = 7;
+
+	const char* NameBuffer = Target[0].Name.data();
+	const int* FirstValue = &Target[1].Attributes.begin()->second;
+
+	TK::FMemReader Reader(Writer.GetBuffer(), Writer.GetSize());
+	Reader.SetReuseContainers(true);
+	Reader & Target;
+	ASSERT_TRUE(Reader.IsValidInput());
+
+	ASSERT_EQ(3u, Target.size());
+	for (int i = 0; i < 3; ++i)
+		Source[i].Check(Target[i]);
+
+	// the old string buffer and map node were loaded over instead of reallocated
+	EXPECT_EQ(NameBuffer, Target[0].Name.data());
+	EXPECT_EQ(FirstValue, &Target[1].Attributes.begin()->second);
+
+	// fewer elements than the message grow one at a time
+	std::vector<FUserData> Grown(1);
+	TK::FMemReader GrowReader(Writer.GetBuffer(), Writer.GetSize());
+	GrowReader.SetReuseContainers(true);
+	GrowReader & Grown;
+	ASSERT_EQ(3u, Grown.size());
+	Source[2].Check(Grown[2]);
+
+	std::map<int, std::string> Map = {{1, "one"}, {2, "two"}};
+	TK::TMemWriter<0> MapWriter;
+	MapWriter & Map;
+
+	std::map<int, std::string> Duplicated = {{5, "five"}};
+	std::vector<char> Bytes(MapWriter.GetBuffer(), MapWriter.GetBuffer() + MapWriter.GetSize());
+	std::memcpy(Bytes.data() + 4 + 4 + 4 + 3, Bytes.data() + 4, 4);
+	TK::FMemReader DuplicateReader(Bytes.data(), Bytes.size());
+	DuplicateReader.SetReuseContainers(true);
+	DuplicateReader & Duplicated;
+	EXPECT_FALSE(DuplicateReader.IsValidInput());
+}
+
+namespace TEST_SER
+{
+	struct FChat
+	{
+		using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+		FChat() = default;
+
+		explicit FChat(const allocator_type& Allocator) : Text(Allocator), Tags(Allocator), Counts(Allocator), Ids(Allocator) {}
+
+		std::pmr::string Text;
+		std::pmr::vector<std::pmr::string> Tags;
+		std::pmr::map<std::pmr::string, int> Counts;
+		std::pmr::vector<int> Ids;
+
+		TK_SERIAL(Text, Tags, Counts, Ids)
+	};
+}
+
+TEST(Serialize, PmrArena)
+{
+	using namespace TEST_SER;
+
+	FChat Source;
+	Source.Text = "a message text long enough to leave the small string buffer";
+	Source.Tags = {"first tag that is long enough to allocate", "second"};
+	Source.Counts["a key long enough to need its own allocation"] = 3;
+	Source.Counts["b"] = 4;
+	Source.Ids = {1, 2, 3};
+
+	TK::TMemWriter<0> Writer;
+	Writer & Source;
+
+	// std and pmr containers share the wire format
+	TK::FMemReader PlainReader(Writer.GetBuffer(), Writer.GetSize());
+	std::string Text;
+	std::vector<std::string> Tags;
+	PlainReader & Text & Tags;
+	EXPECT_EQ(Source.Text, std::string_view(Text));
+	EXPECT_EQ("second", Tags[1]);
+
+	static_assert(TK::IsAllocatorAware<FChat, TK::FMessageArena::AllocatorType>);
+	static_assert(TK::IsAllocatorAware<std::pmr::vector<int>, TK::FMessageArena::AllocatorType>);
+	static_assert(!TK::IsAllocatorAware<FUserData, TK::FMessageArena::AllocatorType>, "would miss the arena");
+
+	TK::FMessageArena Arena;
+	for (int Round = 0; Round < 3; ++Round)
+	{
+		TK::FMemReader Reader(Writer.GetBuffer(), Writer.GetSize());
+		Reader.SetReuseContainers(Round == 2);
+
+		FChat Chat = Arena.Load<FChat>(Reader);
+		ASSERT_TRUE(Reader.IsValidInput());
+		EXPECT_EQ(Source.Text, Chat.Text);
+		EXPECT_EQ(Source.Tags, Chat.Tags);
+		EXPECT_EQ(Source.Counts, Chat.Counts);
+		EXPECT_EQ(Source.Ids, Chat.Ids);
+
+		std::pmr::memory_resource* Resource = Arena.GetResource();
+		EXPECT_EQ(Resource, Chat.Text.get_allocator().resource());
+		EXPECT_EQ(Resource, Chat.Tags[0].get_allocator().resource());
+		EXPECT_EQ(Resource, Chat.Counts.begin()->first.get_allocator().resource());
+		EXPECT_EQ(Resource, Chat.Ids.get_allocator().resource());
+
+		// everything above came from the inline buffer
+		auto Inline = reinterpret_cast<const char*>(&Arena);
+		EXPECT_TRUE(Chat.Tags[0].data() > Inline && Chat.Tags[0].data() < Inline + sizeof(Arena));
+	}
+	Arena.Reset();
+}
+
+namespace TEST_SER
+{
+	struct FHot
+	{
+		int A {0};
+		float B {0.0f};
+		std::int64_t C {0};
+		bool bFlag {false};
+		std::uint16_t D[3] {};
+		EColor Color {EColor::Red};
+		int Level {1};
+		double E {0.0};
+		std::string Name;
+		short F {0};
+
+		TK_SERIAL(A, B, C, bFlag, D, Color, TK::Ranged<1, 100>(Level), E, Name, F)
+	};
+}
+
+TEST(Serialize, FusedFields)
+{
+	using namespace TEST_SER;
+
+	using FieldsType = decltype(std::declval<FHot&>().SerialFields());
+	static_assert(TK::IsFusedArg<int&> && TK::IsFusedArg<const float(&)[3]> && TK::IsFusedArg<EColor&>);
+	static_assert(!TK::IsFusedArg<bool&> && !TK::IsFusedArg<TK::TRangedRef<int, 1, 100>> && !TK::IsFusedArg<FDummy&>);
+	static_assert(std::tuple_size_v<FieldsType> == 10);
+
+	FHot Source;
+	Source.A = -3;
+	Source.B = 1.5f;
+	Source.C = std::int64_t(1) << 40;
+	Source.bFlag = true;
+	Source.D[0] = 7;
+	Source.D[2] = 300;
+	Source.Color = EColor::Blue;
+	Source.Level = 42;
+	Source.E = -2.25;
+	Source.Name = "fused";
+	Source.F = -9;
+
+	for (TK::EIntEncoding Encoding : {TK::EIntEncoding::Fixed, TK::EIntEncoding::Varint})
+	{
+		TK::TMemWriter<0> Fused;
+		Fused.SetIntEncoding(Encoding);
+		Fused & Source;
+
+		// one field at a time, as the macro expanded before runs were fused
+		TK::TMemWriter<0> Single;
+		Single.SetIntEncoding(Encoding);
+		Single & Source.A & Source.B & Source.C & Source.bFlag & Source.D & Source.Color;
+		Single & TK::Ranged<1, 100>(Source.Level) & Source.E & Source.Name & Source.F;
+
+		ASSERT_EQ(Single.GetSize(), Fused.GetSize());
+		EXPECT_EQ(0, std::memcmp(Single.GetBuffer(), Fused.GetBuffer(), Single.GetSize()));
+
+		TK::FMemReader Reader(Fused.GetBuffer(), Fused.GetSize());
+		Reader.SetIntEncoding(Encoding);
+		FHot Copy;
+		Reader & Copy;
+		ASSERT_TRUE(Reader.IsValidInput());
+		EXPECT_EQ(Source.A, Copy.A);
+		EXPECT_EQ(Source.B, Copy.B);
+		EXPECT_EQ(Source.C, Copy.C);
+		EXPECT_EQ(Source.bFlag, Copy.bFlag);
+		EXPECT_EQ(Source.D[2], Copy.D[2]);
+		EXPECT_EQ(Source.Color, Copy.Color);
+		EXPECT_EQ(Source.Level, Copy.Level);
+		EXPECT_EQ(Source.E, Copy.E);
+		EXPECT_EQ(Source.Name, Copy.Name);
+		EXPECT_EQ(Source.F, Copy.F);
+	}
+
+	// a run cut short leaves its fields untouched
+	TK::TMemWriter<0> Writer;
+	Writer & Source;
+	TK::FSegmentedReader Truncated({{Writer.GetBuffer(), 10}});
+	FHot Partial;
+	Truncated & Partial;
+	EXPECT_FALSE(Truncated.IsValidInput());
+	EXPECT_EQ(0, Partial.A);
+	EXPECT_EQ(0.0f, Partial.B);
+}
+
+TEST(Serialize, MaxEncodedSize)
+{
+	using namespace TEST_SER;
+
+	static_assert(TK::MaxEncodedSize<bool> == 1 && TK::MaxEncodedSize<char> == 1 && TK::MaxEncodedSize<double> == 8);
+	static_assert(TK::MaxEncodedSize<std::int16_t> == 3 && TK::MaxEncodedSize<std::int32_t> == 5);
+	static_assert(TK::MaxEncodedSize<std::uint64_t> == 10 && TK::MaxEncodedSize<EColor> == 3);
+	static_assert(TK::MaxEncodedSize<std::uint16_t[3]> == 9 && TK::MaxEncodedSize<std::array<float, 3>> == 12);
+	static_assert(TK::MaxEncodedSize<FSwapped> == 10);
+	static_assert(TK::MaxEncodedSize<FStats> == 1 + 5 + 3 + 12 + 10);
+	static_assert(TK::MaxEncodedSize<std::string> == 0 && TK::MaxEncodedSize<FHot> == 0, "no bound");
+	static_assert(TK::MaxPackedSize<int, FStats> == 5 + 31 && TK::MaxPackedSize<int, std::string> == 0);
+
+	using FStatsMessage = TK::TMessageFor<std::int32_t, FStats>;
+	static_assert(std::is_base_of_v<TK::TMemWriter<4 + 5 + 31, TK::TPoolAllocator<char>>, FStatsMessage>);
+
+	// the widest values reach the bound in varint mode and stay under it in fixed mode
+	FStats Source { true, 100, EColor::Blue, {1.0f, 2.0f, 3.0f}, {-2147483647 - 1, 2147483647} };
+	std::int32_t Id = -2147483647 - 1;
+
+	for (TK::EIntEncoding Encoding : {TK::EIntEncoding::Fixed, TK::EIntEncoding::Varint})
+	{
+		FStatsMessage Message(9);
+		Message.SetIntEncoding(Encoding);
+		Message.PackBounded(Id, Source);
+
+		EXPECT_LE(Message.GetSize(), Message.GetCapacity());
+		EXPECT_EQ(static_cast<std::size_t>(TK::FMessage::GetHeadSize() + 31 + 5), Message.GetCapacity());
+		EXPECT_TRUE(Message.UpdateHeader());
+
+		TK::FMessage Expected(9);
+		Expected.SetIntEncoding(Encoding);
+		Expected.Pack(Id, Source);
+		Expected.UpdateHeader();
+		ASSERT_EQ(Expected.GetSize(), Message.GetSize());
+		EXPECT_EQ(0, std::memcmp(Expected.GetBuffer(), Message.GetBuffer(), Message.GetSize()));
+
+		TK::FMemReader Reader(Message.GetBuffer() + TK::FMessage::GetHeadSize(), Message.GetSize() - TK::FMessage::GetHeadSize());
+		Reader.SetIntEncoding(Encoding);
+		std::int32_t IdCopy = 0;
+		FStats Copy {};
+		Reader & IdCopy & Copy;
+		EXPECT_TRUE(Reader.IsValidInput());
+		EXPECT_EQ(0, Reader.GetUnreadBytes());
+		EXPECT_EQ(Id, IdCopy);
+		EXPECT_EQ(2147483647, Copy.Pair.B);
+
+		// a second pack has no room left inline and takes the checked path
+		Message.PackBounded(Id, Source);
+		EXPECT_EQ(Expected.GetSize() * 2 - TK::FMessage::GetHeadSize(), Message.GetSize());
+	}
+
+	// bounded messages go through the same sender as FMessage
+	std::vector<std::string> Sent;
+	TK::FSender Sender = [&](TK::FMessageBase& Message)
+	{
+		EXPECT_TRUE(Message.UpdateHeader());
+		EXPECT_EQ(Message.GetSize(), Message.GetHeader()->Size);
+		Sent.emplace_back(Message.GetBuffer(), Message.GetSize());
+	};
+
+	FStatsMessage Bounded(9);
+	Bounded.PackBounded(Id, Source);
+	Sender(Bounded);
+
+	TK::FMessage Plain(9);
+	Plain.Pack(Id, Source);
+	Sender(Plain);
+
+	ASSERT_EQ(2u, Sent.size());
+	EXPECT_EQ(Sent[1], Sent[0]);
+}
+
+TEST(Serialize, SpanWriter)
+{
+	TEST_SER::FUserData Source {};
+	Source.Name = "span";
+	Source.Scores = {1, 2};
+
+	TK::TMemWriter<0> Expected;
+	Expected & Source;
+
+	// a send ring slot with a caller filled length in front of the payload
+	char Slot[256];
+	TK::FSpanWriter Writer(Slot, sizeof(Slot));
+	char* Length = Writer.ReserveBytes(sizeof(std::uint32_t));
+	ASSERT_NE(nullptr, Length);
+	Writer & Source;
+
+	ASSERT_TRUE(Writer.IsValidOutput());
+	ASSERT_EQ(sizeof(std::uint32_t) + Expected.GetSize(), Writer.GetSize());
+	EXPECT_EQ(Slot, Writer.GetBuffer());
+	EXPECT_EQ(sizeof(Slot) - Writer.GetSize(), Writer.GetAvailableSpace());
+
+	std::uint32_t PayloadSize = static_cast<std::uint32_t>(Expected.GetSize());
+	std::memcpy(Length, &PayloadSize, sizeof(PayloadSize));
+	EXPECT_EQ(0, std::memcmp(Expected.GetBuffer(), Slot + sizeof(std::uint32_t), Expected.GetSize()));
+
+	TK::FMemReader Reader(Slot, Writer.GetSize());
+	std::uint32_t LengthCopy = 0;
+	TEST_SER::FUserData Copy;
+	Reader & LengthCopy & Copy;
+	EXPECT_TRUE(Reader.IsValidInput());
+	EXPECT_EQ(PayloadSize, LengthCopy);
+	EXPECT_EQ(Source.Name, Copy.Name);
+
+	// the string's size fits, its characters do not and are not written at all
+	char Small[8];
+	TK::FSpanWriter Full(Small, sizeof(Small));
+	Full & std::int32_t(5);
+	Full & std::string("too long");
+	EXPECT_FALSE(Full.IsValidOutput());
+	EXPECT_EQ(sizeof(std::int32_t) + sizeof(std::uint32_t), Full.GetSize());
+	EXPECT_EQ(nullptr, Full.ReserveBytes(0));
+
+	Full.Clear();
+	EXPECT_TRUE(Full.IsValidOutput());
+
+	// a negative length is a no-op, as on TMemWriter
+	Full.Push(Small, -1);
+	EXPECT_TRUE(Full.IsValidOutput());
+	EXPECT_EQ(0u, Full.GetSize());
+	EXPECT_EQ(nullptr, Full.ReserveBytes(9));
+	EXPECT_FALSE(Full.IsValidOutput());
+
+	Full.Init(Slot, sizeof(Slot));
+	Full.SetIntEncoding(TK::EIntEncoding::Varint);
+	Full & Source;
+	EXPECT_TRUE(Full.IsValidOutput());
+	Full.ShrinkTo(2);
+	EXPECT_EQ(2u, Full.GetSize());
+	EXPECT_EQ(TK::EIntEncoding::Varint, Full.GetIntEncoding());
+}
+
+TEST(Serialize, SharedBuffer)
+{
+	const std::string Small = "small";
+	const std::string Large(300, 'l');
+
+	// inline bytes are moved into the shared block
+	TK::TMemWriter<64> Inline;
+	Inline & Small;
+	TK::TMemWriter<0> Expected;
+	Expected & Small;
+
+	TK::FSharedBuffer Frozen = TK::Freeze(Inline);
+	ASSERT_EQ(Expected.GetSize(), Frozen.GetSize());
+	EXPECT_EQ(0, std::memcmp(Expected.GetBuffer(), Frozen.GetData(), Frozen.GetSize()));
+	EXPECT_EQ(0u, Inline.GetSize());
+	EXPECT_EQ(1, Frozen.GetUseCount());
+
+	// a heap buffer is stolen, not copied
+	TK::TMemWriter<16> Heap;
+	Heap & Large;
+	const char* HeapData = Heap.GetBuffer();
+	std::size_t HeapSize = Heap.GetSize();
+
+	TK::FSharedBuffer Stolen = TK::Freeze(Heap);
+	EXPECT_EQ(HeapData, Stolen.GetData());
+	EXPECT_EQ(HeapSize, Stolen.GetSize());
+	EXPECT_EQ(0u, Heap.GetSize());
+
+	// the writer is usable again, and copies share the same bytes
+	Heap & Small;
+	EXPECT_TRUE(Heap.IsValidOutput());
+	{
+		std::vector<TK::FSharedBuffer> Queues(10, Stolen);
+		EXPECT_EQ(11, Stolen.GetUseCount());
+		EXPECT_EQ(HeapData, Queues.back().GetData());
+	}
+	EXPECT_EQ(1, Stolen.GetUseCount());
+
+	TK::FMemReader Reader(Stolen.GetData(), Stolen.GetSize());
+	std::string Copy;
+	Reader & Copy;
+	EXPECT_EQ(Large, Copy);
+
+	TK::TMemWriter<16> Empty;
+	EXPECT_TRUE(TK::Freeze(Empty).IsEmpty());
+	Empty.MarkOutputInvalid();
+	EXPECT_TRUE(TK::Freeze(Empty).IsEmpty());
+	EXPECT_TRUE(Empty.IsValidOutput());
+
+	// a frozen message has its header filled in, the message keeps only its header
+	TK::FMessage Message(5);
+	Message.Pack(Large);
+	std::size_t MessageSize = Message.GetSize();
+
+	TK::FSharedBuffer Broadcast = Message.Freeze();
+	ASSERT_EQ(MessageSize, Broadcast.GetSize());
+	auto Header = reinterpret_cast<const TK::FMessage::FHeader*>(Broadcast.GetData());
+	EXPECT_EQ(MessageSize, Header->Size);
+	EXPECT_EQ(5, Header->Tag);
+	EXPECT_EQ(static_cast<std::size_t>(TK::FMessage::GetHeadSize()), Message.GetSize());
+	EXPECT_EQ(5, Message.GetHeader()->Tag);
+}
+
+TEST(Serialize, LengthSlot)
+{
+	using namespace TEST_SER;
+
+	static_assert(TK::CanBackfill<TK::TMemWriter<0>> && TK::CanBackfill<TK::FMessage> && TK::CanBackfill<TK::FSpanWriter>);
+	static_assert(TK::CanBackfill<TK::FSegmentedWriter> && TK::CanBackfill<TK::FSizeCounter>);
+	static_assert(!TK::CanBackfill<TK::TCrcWriter<TK::TMemWriter<0>>> && !TK::CanCompactSlot<TK::FSegmentedWriter>);
+
+	// nested slots, varints shorter than their slot are compacted
+	for (std::size_t Length : {0, 5, 127, 128, 20000})
+	{
+		TK::TMemWriter<16> Writer;
+		TK::FLengthSlot Outer = TK::BeginLengthSlot(Writer, TK::ELengthSlot::Fixed32);
+		TK::FLengthSlot Inner = TK::BeginLengthSlot(Writer, TK::ELengthSlot::Varint);
+		Writer & std::string(Length, 'n');
+		TK::EndLengthSlot(Writer, Inner);
+		Writer & std::int16_t(-7);
+		TK::EndLengthSlot(Writer, Outer);
+
+		TK::TMemWriter<0> Expected;
+		TK::TMemWriter<0> Child;
+		Child & std::string(Length, 'n');
+		TK::SaveVarint(Expected, static_cast<std::uint32_t>(Child.GetSize()));
+		Expected.Push(Child.GetBuffer(), Child.GetSize());
+		Expected & std::int16_t(-7);
+
+		ASSERT_EQ(sizeof(std::uint32_t) + Expected.GetSize(), Writer.GetSize());
+		std::uint32_t OuterLength = 0;
+		std::memcpy(&OuterLength, Writer.GetBuffer(), sizeof(OuterLength));
+		EXPECT_EQ(Expected.GetSize(), OuterLength);
+		EXPECT_EQ(0, std::memcmp(Expected.GetBuffer(), Writer.GetBuffer() + sizeof(std::uint32_t), Expected.GetSize()));
+
+		// segments never move, the varint is padded to the slot and decodes like a minimal one
+		TK::TSegmentedWriter<64> Segmented;
+		Segmented & std::int16_t(3);
+		TK::FLengthSlot Padded = TK::BeginLengthSlot(Segmented, TK::ELengthSlot::Varint);
+		Segmented & std::string(Length, 'n');
+		TK::EndLengthSlot(Segmented, Padded);
+		ASSERT_EQ(sizeof(std::int16_t) + TK::LengthSlotWidth(TK::ELengthSlot::Varint) + Child.GetSize(), Segmented.GetSize());
+
+		std::vector<char> Bytes(Segmented.GetSize());
+		Segmented.CopyTo(Bytes.data());
+		TK::FMemReader Reader(Bytes.data(), Bytes.size());
+		Reader.SetIntEncoding(TK::EIntEncoding::Varint);
+		Reader.Advance(sizeof(std::int16_t));
+		std::uint32_t InnerLength = 0;
+		TK::LoadVarint(Reader, InnerLength);
+		ASSERT_TRUE(Reader.IsValidInput());
+		EXPECT_EQ(Child.GetSize(), InnerLength);
+		EXPECT_EQ(Child.GetSize(), static_cast<std::size_t>(Reader.GetUnreadBytes()));
+	}
+
+	// bytes handed out by ReserveBytes inside a slot keep their place
+	{
+		char Region[32] {};
+		TK::FSpanWriter Span(Region, sizeof(Region));
+		TK::FLengthSlot Slot = TK::BeginLengthSlot(Span, TK::ELengthSlot::Varint);
+		char* Reserved = Span.ReserveBytes(2);
+		TK::EndLengthSlot(Span, Slot);
+		EXPECT_EQ(Region + TK::LengthSlotWidth(TK::ELengthSlot::Varint), Reserved);
+		EXPECT_EQ(TK::LengthSlotWidth(TK::ELengthSlot::Varint) + 2, Span.GetSize());
+
+		Span.Clear();
+		Slot = TK::BeginLengthSlot(Span, TK::ELengthSlot::Varint);
+		Span & std::int16_t(1);
+		TK::EndLengthSlot(Span, Slot);
+		EXPECT_EQ(1 + sizeof(std::int16_t), Span.GetSize());
+	}
+
+	FSession Session;
+	Session.ID = 3;
+	Session.Profile.Name = "backfill";
+	Session.Profile.Items = {1, 200, 30000};
+
+	FCatalog Catalog;
+	for (int i = 0; i < 20; ++i)
+	{
+		Catalog.Names.push_back("name" + std::to_string(i));
+		Catalog.Prices[i] = i * 1.5f;
+	}
+
+	FEnvelope Envelope;
+	Envelope.Route = 9;
+	Envelope.Payload = FUserData();
+	Envelope.Payload.GetMutable().Name = std::string(300, 'p');
+
+	for (TK::EIntEncoding Encoding : {TK::EIntEncoding::Fixed, TK::EIntEncoding::Varint})
+	{
+		TK::TMemWriter<64> Writer;
+		Writer.SetIntEncoding(Encoding);
+		Writer & Session & Catalog & Envelope;
+		ASSERT_TRUE(Writer.IsValidOutput());
+
+		TK::FSizeCounter Counter;
+		Counter.SetIntEncoding(Encoding);
+		Counter & Session & Catalog & Envelope;
+		EXPECT_EQ(Writer.GetSize(), Counter.GetSize());
+
+		// compacting writers and the scratch fallback give the same bytes
+		std::vector<char> Slot(Writer.GetSize() + 8);
+		TK::FSpanWriter Span(Slot.data(), Slot.size());
+		Span.SetIntEncoding(Encoding);
+		Span & Session & Catalog & Envelope;
+		ASSERT_EQ(Writer.GetSize(), Span.GetSize());
+		EXPECT_EQ(0, std::memcmp(Writer.GetBuffer(), Slot.data(), Writer.GetSize()));
+
+		TK::TMemWriter<0> Passed;
+		TK::TCrcWriter<TK::TMemWriter<0>> Crc(Passed);
+		Crc.SetIntEncoding(Encoding);
+		Crc & Session & Catalog & Envelope;
+		ASSERT_EQ(Writer.GetSize(), Passed.GetSize());
+		EXPECT_EQ(0, std::memcmp(Writer.GetBuffer(), Passed.GetBuffer(), Writer.GetSize()));
+
+		// padded segments load back to the same values
+		TK::FSegmentedWriter Segmented;
+		Segmented.SetIntEncoding(Encoding);
+		Segmented & Session & Catalog & Envelope;
+		std::vector<char> Bytes(Segmented.GetSize());
+		Segmented.CopyTo(Bytes.data());
+
+		TK::FMemReader Reader(Bytes.data(), Bytes.size());
+		Reader.SetIntEncoding(Encoding);
+		FSession LoadedSession;
+		FCatalog LoadedCatalog;
+		FEnvelope LoadedEnvelope;
+		Reader & LoadedSession & LoadedCatalog & LoadedEnvelope;
+		ASSERT_TRUE(Reader.IsValidInput());
+		EXPECT_EQ(0, Reader.GetUnreadBytes());
+
+		TK::TMemWriter<0> Resaved;
+		Resaved.SetIntEncoding(Encoding);
+		Resaved & LoadedSession & LoadedCatalog & LoadedEnvelope;
+		ASSERT_EQ(Writer.GetSize(), Resaved.GetSize());
+		EXPECT_EQ(0, std::memcmp(Writer.GetBuffer(), Resaved.GetBuffer(), Writer.GetSize()));
+
+		// a slot that does not fit leaves the output invalid, nothing is backfilled past the end
+		TK::FSpanWriter Short(Slot.data(), 6);
+		Short.SetIntEncoding(Encoding);
+		Short & Envelope;
+		EXPECT_FALSE(Short.IsValidOutput());
+	}
+}